@@ -0,0 +1,146 @@
+// MessagePack minimal (spec 2.0, sans extensions) pour les échanges avec
+// l'ESP32 : objets, tableaux, chaînes, nombres, booléens et null. Les entiers
+// au-delà de 2^53 (uint64 de l'ESP32) sont lus comme des nombres arrondis.
+
+function encode(value) {
+    const chunks = [];
+    write(value, chunks);
+    return Buffer.concat(chunks);
+}
+
+function header(byte, size, length) {
+    const b = Buffer.alloc(1 + size);
+    b[0] = byte;
+    if (size === 1) b.writeUInt8(length, 1);
+    else if (size === 2) b.writeUInt16BE(length, 1);
+    else if (size === 4) b.writeUInt32BE(length, 1);
+    return b;
+}
+
+function writeInteger(n, chunks) {
+    if (n >= 0) {
+        if (n < 0x80) return chunks.push(Buffer.from([n]));
+        if (n <= 0xff) return chunks.push(header(0xcc, 1, n));
+        if (n <= 0xffff) return chunks.push(header(0xcd, 2, n));
+        if (n <= 0xffffffff) return chunks.push(header(0xce, 4, n));
+        const b = Buffer.alloc(9);
+        b[0] = 0xcf;
+        b.writeBigUInt64BE(BigInt(n), 1);
+        return chunks.push(b);
+    }
+    if (n >= -32) return chunks.push(Buffer.from([n & 0xff]));
+    if (n >= -0x80) { const b = Buffer.alloc(2); b[0] = 0xd0; b.writeInt8(n, 1); return chunks.push(b); }
+    if (n >= -0x8000) { const b = Buffer.alloc(3); b[0] = 0xd1; b.writeInt16BE(n, 1); return chunks.push(b); }
+    if (n >= -0x80000000) { const b = Buffer.alloc(5); b[0] = 0xd2; b.writeInt32BE(n, 1); return chunks.push(b); }
+    const b = Buffer.alloc(9);
+    b[0] = 0xd3;
+    b.writeBigInt64BE(BigInt(n), 1);
+    return chunks.push(b);
+}
+
+function write(value, chunks) {
+    if (value === null || value === undefined) return chunks.push(Buffer.from([0xc0]));
+    if (value === true || value === false) return chunks.push(Buffer.from([value ? 0xc3 : 0xc2]));
+    if (typeof value === 'number') {
+        if (Number.isSafeInteger(value)) return writeInteger(value, chunks);
+        const b = Buffer.alloc(9);
+        b[0] = 0xcb;
+        b.writeDoubleBE(value, 1);
+        return chunks.push(b);
+    }
+    if (typeof value === 'string') {
+        const s = Buffer.from(value, 'utf8');
+        if (s.length < 32) chunks.push(Buffer.from([0xa0 | s.length]));
+        else if (s.length <= 0xff) chunks.push(header(0xd9, 1, s.length));
+        else if (s.length <= 0xffff) chunks.push(header(0xda, 2, s.length));
+        else chunks.push(header(0xdb, 4, s.length));
+        return chunks.push(s);
+    }
+    if (value instanceof Date) return write(value.toISOString(), chunks);
+    if (Array.isArray(value)) {
+        if (value.length < 16) chunks.push(Buffer.from([0x90 | value.length]));
+        else if (value.length <= 0xffff) chunks.push(header(0xdc, 2, value.length));
+        else chunks.push(header(0xdd, 4, value.length));
+        return value.forEach(v => write(v, chunks));
+    }
+    // Objet : les clés undefined sont omises, comme JSON.stringify
+    const keys = Object.keys(value).filter(k => value[k] !== undefined);
+    if (keys.length < 16) chunks.push(Buffer.from([0x80 | keys.length]));
+    else if (keys.length <= 0xffff) chunks.push(header(0xde, 2, keys.length));
+    else chunks.push(header(0xdf, 4, keys.length));
+    keys.forEach(k => { write(k, chunks); write(value[k], chunks); });
+}
+
+function decode(buffer) {
+    const state = { buf: buffer, pos: 0 };
+    const value = read(state, 0);
+    if (state.pos !== buffer.length) throw new Error('msgpack: octets en trop');
+    return value;
+}
+
+function take(state, n) {
+    if (state.pos + n > state.buf.length) throw new Error('msgpack: corps incomplet');
+    const at = state.pos;
+    state.pos += n;
+    return at;
+}
+
+function readString(state, length) {
+    const at = take(state, length);
+    return state.buf.toString('utf8', at, at + length);
+}
+
+function readArray(state, length, depth) {
+    const out = [];
+    for (let i = 0; i < length; i++) out.push(read(state, depth + 1));
+    return out;
+}
+
+// Clés posées en propriétés propres, comme JSON.parse : une clé "__proto__"
+// reste une donnée et ne remplace pas le prototype de l'objet décodé.
+function readMap(state, length, depth) {
+    const out = {};
+    for (let i = 0; i < length; i++) {
+        const key = read(state, depth + 1);
+        const value = read(state, depth + 1);
+        Object.defineProperty(out, String(key), { value, enumerable: true, writable: true, configurable: true });
+    }
+    return out;
+}
+
+function read(state, depth) {
+    if (depth > 32) throw new Error('msgpack: imbrication trop profonde');
+    const b = state.buf;
+    const c = b[take(state, 1)];
+    if (c < 0x80) return c;
+    if (c >= 0xe0) return c - 0x100;
+    if ((c & 0xf0) === 0x80) return readMap(state, c & 0x0f, depth);
+    if ((c & 0xf0) === 0x90) return readArray(state, c & 0x0f, depth);
+    if ((c & 0xe0) === 0xa0) return readString(state, c & 0x1f);
+    switch (c) {
+        case 0xc0: return null;
+        case 0xc2: return false;
+        case 0xc3: return true;
+        // float32 de l'ESP32 : ramené à sa précision (24.3 et non 24.299999237060547)
+        case 0xca: return Number(b.readFloatBE(take(state, 4)).toPrecision(7));
+        case 0xcb: return b.readDoubleBE(take(state, 8));
+        case 0xcc: return b.readUInt8(take(state, 1));
+        case 0xcd: return b.readUInt16BE(take(state, 2));
+        case 0xce: return b.readUInt32BE(take(state, 4));
+        case 0xcf: return Number(b.readBigUInt64BE(take(state, 8)));
+        case 0xd0: return b.readInt8(take(state, 1));
+        case 0xd1: return b.readInt16BE(take(state, 2));
+        case 0xd2: return b.readInt32BE(take(state, 4));
+        case 0xd3: return Number(b.readBigInt64BE(take(state, 8)));
+        case 0xd9: return readString(state, b.readUInt8(take(state, 1)));
+        case 0xda: return readString(state, b.readUInt16BE(take(state, 2)));
+        case 0xdb: return readString(state, b.readUInt32BE(take(state, 4)));
+        case 0xdc: return readArray(state, b.readUInt16BE(take(state, 2)), depth);
+        case 0xdd: return readArray(state, b.readUInt32BE(take(state, 4)), depth);
+        case 0xde: return readMap(state, b.readUInt16BE(take(state, 2)), depth);
+        case 0xdf: return readMap(state, b.readUInt32BE(take(state, 4)), depth);
+    }
+    throw new Error('msgpack: type 0x' + c.toString(16) + ' non pris en charge');
+}
+
+module.exports = { encode, decode };
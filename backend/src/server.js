@@ -1,10 +1,70 @@
 const express = require('express');
 const cors = require('cors');
+const msgpack = require('./msgpack');
 const app = express();
 const PORT = 3001;
 
 app.use(cors());
 app.use(express.json());
+// Corps MessagePack de l'ESP32 (négocié : il n'en envoie qu'après une réponse dans ce format)
+app.use(express.raw({ type: 'application/msgpack' }));
+app.use((req, res, next) => {
+    if (!req.is('application/msgpack')) return next();
+    try {
+        req.body = msgpack.decode(req.body);
+    } catch (e) {
+        return res.status(400).json({ error: e.message });
+    }
+    next();
+});
+
+// Cadence de poll dictée à l'ESP32 (nextPollMs) : accélérée tant qu'un
+// utilisateur pilote la fenêtre, ralentie quand les requêtes de la flotte
+// dépassent LOAD_BUDGET_RPS (mesurées par fenêtres de 10 s, hors long-polls
+// qui suivent les changements d'ordre et non la période). Au-delà du double
+// du budget, retryAfter (s, tiré au hasard pour étaler les retours) suspend
+// en plus le prochain poll. Rien n'est envoyé au régime normal : l'ESP32 garde
+// sa propre période.
+const POLL_BASE_MS = 2000;
+const POLL_ACTIVE_MS = 1000;
+const POLL_MAX_MS = 60000;
+const ACTIVE_WINDOW_MS = 60000;
+const LOAD_WINDOW_MS = 10000;
+const LOAD_BUDGET_RPS = Number(process.env.LOAD_BUDGET_RPS) || 50;
+let lastControlAt = 0;
+let pollMs = POLL_BASE_MS;
+let loadRate = 0;
+let loadWindow = { start: Date.now(), count: 0 };
+
+function countRequest() {
+    const now = Date.now();
+    loadWindow.count++;
+    if (now - loadWindow.start < LOAD_WINDOW_MS) return;
+    loadRate = loadWindow.count * 1000 / (now - loadWindow.start);
+    // La charge varie comme 1 / période : une correction proportionnelle vise le budget
+    pollMs = Math.round(Math.min(POLL_MAX_MS, Math.max(POLL_BASE_MS, pollMs * loadRate / LOAD_BUDGET_RPS)));
+    loadWindow = { start: now, count: 0 };
+}
+
+function pacing() {
+    if (pollMs > POLL_BASE_MS) {
+        const pace = { nextPollMs: pollMs };
+        if (loadRate > 2 * LOAD_BUDGET_RPS) pace.retryAfter = 1 + Math.floor(Math.random() * Math.ceil(pollMs / 1000));
+        return pace;
+    }
+    if (Date.now() - lastControlAt < ACTIVE_WINDOW_MS) return { nextPollMs: POLL_ACTIVE_MS };
+    return {};
+}
+
+// Réponse aux routes de l'ESP32, cadence comprise : MessagePack s'il le demande (Accept), JSON sinon
+function reply(req, res, body) {
+    if (!req.query.wait) countRequest();
+    body = { ...body, ...pacing() };
+    if (req.accepts(['application/json', 'application/msgpack']) === 'application/msgpack') {
+        return res.type('application/msgpack').send(msgpack.encode(body));
+    }
+    res.json(body);
+}
 
 // État global
 let windowState = {
@@ -16,47 +76,181 @@ let windowState = {
 
 // Variable pour stocker l'ordre manuel : 'AUTO', 'OPEN', ou 'CLOSE'
 let currentCommand = 'AUTO';
+// Ouverture demandée avec 'OPEN', en % (0-100)
+let currentPosition = 100;
+// Version de l'ordre (ms, croissante même après un redémarrage du serveur) et
+// long-polls de l'ESP32 en attente d'un changement
+let commandVersion = Date.now();
+let commandWaiters = [];
+
+function setCommand(command, position = 100) {
+    if (command === currentCommand && position === currentPosition) return;
+    currentCommand = command;
+    currentPosition = position;
+    commandVersion = Math.max(Date.now(), commandVersion + 1);
+    const waiters = commandWaiters;
+    commandWaiters = [];
+    waiters.forEach(wake => wake());
+}
+
+// Temps de démarrage par version du firmware (boot → WiFi, boot → première
+// télémétrie), chaque démarrage compté une fois (numéro `n` de l'ESP32)
+let bootsByVersion = {};
+let lastBoot = null;
+
+function recordBoot(boot) {
+    if (!boot || !boot.telemetryMs || (lastBoot && lastBoot.n === boot.n && lastBoot.fw === boot.fw)) return;
+    lastBoot = boot;
+    const v = bootsByVersion[boot.fw] || (bootsByVersion[boot.fw] = { boots: 0, fast: 0, fallbacks: 0, wifiMs: [], telemetryMs: [] });
+    v.boots++;
+    if (boot.fast) v.fast++;
+    v.fallbacks += boot.fallbacks || 0;
+    v.wifiMs.push(boot.wifiMs);
+    v.telemetryMs.push(boot.telemetryMs);
+}
+
+function median(values) {
+    const sorted = [...values].sort((a, b) => a - b);
+    return sorted.length ? sorted[Math.floor(sorted.length / 2)] : null;
+}
+
+// Santé réseau de l'ESP32 : résumés par étape (DNS, connexion, TLS, envoi,
+// attente, corps, parsing → [n, p50, p90] en µs), un par minute environ
+const NET_HISTORY_MAX = 1440;
+let netHistory = [];
+
+function recordNet(net) {
+    if (!net) return;
+    windowState.net = net;
+    netHistory.push({ ts: Date.now(), ...net });
+    if (netHistory.length > NET_HISTORY_MAX) netHistory.splice(0, netHistory.length - NET_HISTORY_MAX);
+}
+
+// Historique des échantillons, trié par date (les lots de rattrapage arrivent en retard).
+// Après un redémarrage en plein rattrapage, l'ESP32 renvoie la fin du segment
+// déjà reçue : un échantillon identique à la même date n'est gardé qu'une fois.
+const HISTORY_MAX = 20000;
+let history = [];
+
+function recordSample({ ts, temp, aqi, isOpen }) {
+    const sample = { ts: ts ? ts * 1000 : Date.now(), temp, aqi, isOpen };
+    let i = history.length;
+    while (i > 0 && history[i - 1].ts > sample.ts) i--;
+    for (let j = i - 1; ts && j >= 0 && history[j].ts === sample.ts; j--) {
+        const h = history[j];
+        if (h.temp === temp && h.aqi === aqi && h.isOpen === isOpen) return;
+    }
+    history.splice(i, 0, sample);
+    if (history.length > HISTORY_MAX) history.splice(0, history.length - HISTORY_MAX);
+}
 
 // 1. L'ESP32 envoie ses logs ET reçoit l'ordre en réponse
 app.post('/api/window/log', (req, res) => {
-    const { temp, aqi, isOpen } = req.body;
+    const { temp, aqi, isOpen, opening, weather, tx, heap, act, provision, poll, power, boot, net } = req.body;
     
     // On met à jour l'état vu par le dashboard
     windowState.isOpen = isOpen;
+    if (opening !== undefined) windowState.opening = opening; // ouverture visée, en %
     windowState.temp = temp;
     windowState.aqi = aqi;
     windowState.lastUpdated = new Date();
+    if (weather) windowState.weatherLink = weather; // handshakes et temps des requêtes Open-Meteo
+    if (tx) windowState.tx = tx; // échantillons envoyés / écartés par la bande morte, octets et format des corps
+    if (heap) windowState.heap = heap; // tas libre, minimum et plus gros bloc (fragmentation)
+    if (act) windowState.act = act; // actionnements du servo (ouvertures, fermetures, course, retards)
+    if (provision) windowState.provision = provision; // configurations BLE appliquées, délai jusqu'à l'état opérationnel
+    if (poll) windowState.poll = poll; // période de poll en cours, pauses demandées
+    if (power) windowState.power = power; // mode d'économie d'énergie, part du temps éveillé
+    if (boot) windowState.boot = boot; // démarrage en cours : version, délais WiFi et première télémétrie
+    recordBoot(boot);
+    recordNet(net);
+    recordSample(req.body);
 
     console.log(`[ESP32] Reçu: ${temp}°C | État actuel: ${isOpen?'OUVERT':'FERMÉ'} | Ordre envoyé: ${currentCommand}`);
     
     // C'est ICI la magie : on répond à l'ESP32 avec l'ordre actuel
-    res.json({ 
+    reply(req, res, { 
         success: true, 
-        command: currentCommand 
+        command: currentCommand,
+        position: currentPosition,
+        version: commandVersion
+    });
+});
+
+// 1 bis. Échantillons par lots : mode lots, ou rattrapage de ce que l'ESP32 a stocké en flash pendant une coupure
+app.post('/api/window/log/batch', (req, res) => {
+    const samples = Array.isArray(req.body.samples) ? req.body.samples : [];
+    samples.forEach(recordSample);
+    if (req.body.weather) windowState.weatherLink = req.body.weather;
+    if (req.body.tx) windowState.tx = req.body.tx;
+    if (req.body.heap) windowState.heap = req.body.heap;
+    if (req.body.act) windowState.act = req.body.act;
+    if (req.body.provision) windowState.provision = req.body.provision;
+    if (req.body.poll) windowState.poll = req.body.poll;
+    if (req.body.power) windowState.power = req.body.power;
+    if (req.body.boot) windowState.boot = req.body.boot;
+    recordBoot(req.body.boot);
+    recordNet(req.body.net);
+
+    // Lot en direct (mode lots) : le plus récent devient l'état affiché, sauf s'il est plus vieux que lui (rattrapage).
+    // Sans `ts`, impossible de le situer : il reste dans l'historique, jamais dans l'état affiché.
+    const latest = samples[samples.length - 1];
+    const latestTs = latest && latest.ts ? latest.ts * 1000 : 0;
+    if (latestTs && latestTs >= windowState.lastUpdated.getTime()) {
+        windowState.isOpen = latest.isOpen;
+        windowState.temp = latest.temp;
+        windowState.aqi = latest.aqi;
+        windowState.lastUpdated = new Date(latestTs);
+    }
+
+    console.log(`[ESP32] Lot: ${samples.length} échantillons`);
+    reply(req, res, { success: true, stored: samples.length, command: currentCommand, position: currentPosition, version: commandVersion });
+});
+
+// 1 ter. L'ESP32 relit l'ordre. Avec ?since=<version>&wait=<s>, la réponse attend
+// que l'ordre change (canal push en long-poll), au plus `wait` secondes.
+app.get('/api/window/command', (req, res) => {
+    const answer = () => reply(req, res, { command: currentCommand, position: currentPosition, version: commandVersion });
+    const since = Number(req.query.since);
+    const wait = Math.min(Number(req.query.wait) || 0, 55) * 1000;
+    if (!wait || since !== commandVersion) return answer();
+
+    const wake = () => { clearTimeout(timer); answer(); };
+    const timer = setTimeout(() => {
+        commandWaiters = commandWaiters.filter(w => w !== wake);
+        answer();
+    }, wait);
+    commandWaiters.push(wake);
+    res.on('close', () => {
+        clearTimeout(timer);
+        commandWaiters = commandWaiters.filter(w => w !== wake);
     });
 });
 
 // 2. L'App Mobile envoie un ordre manuel
 app.post('/api/window/control', (req, res) => {
-    const { action, autoMode } = req.body;
+    const { action, autoMode, position } = req.body;
+    lastControlAt = Date.now(); // l'ESP32 poll plus vite tant que l'utilisateur est là
 
     // PRIORITÉ 1 : Si une action explicite (Ouvrir/Fermer) est envoyée
     if (action === 'open') {
-        currentCommand = 'OPEN';
-        console.log("📲 App : Action -> Force OUVERTURE");
+        // Ouverture partielle facultative : { action: 'open', position: 40 }
+        const percent = Number.isFinite(position) ? Math.round(Math.min(Math.max(position, 0), 100)) : 100;
+        setCommand('OPEN', percent);
+        console.log(`📲 App : Action -> Force OUVERTURE (${percent} %)`);
     } 
     else if (action === 'close') {
-        currentCommand = 'CLOSE';
+        setCommand('CLOSE');
         console.log("📲 App : Action -> Force FERMETURE");
     }
     // PRIORITÉ 2 : Si pas d'action, on regarde le changement de mode
     else if (autoMode === true) {
-        currentCommand = 'AUTO';
+        setCommand('AUTO');
         console.log("📲 App : Switch -> Mode AUTO");
     } 
     else if (autoMode === false) {
         // On désactive juste le mode auto, on garde la position actuelle
-        currentCommand = windowState.isOpen ? 'OPEN' : 'CLOSE';
+        setCommand(windowState.isOpen ? 'OPEN' : 'CLOSE', windowState.opening ?? 100);
         console.log("📲 App : Switch -> Mode MANUEL (Maintien position)");
     }
 
@@ -74,6 +268,33 @@ app.get('/api/window/status', (req, res) => {
     });
 });
 
+// 4. Historique (ms epoch), éventuellement à partir de ?since=
+app.get('/api/window/history', (req, res) => {
+    const since = Number(req.query.since) || 0;
+    res.json(history.filter(s => s.ts >= since));
+});
+
+// 5. Temps de démarrage par version du firmware (médianes en ms depuis le boot)
+app.get('/api/window/boot', (req, res) => {
+    const summary = {};
+    for (const [fw, v] of Object.entries(bootsByVersion)) {
+        summary[fw] = {
+            boots: v.boots,
+            fast: v.fast,
+            fallbacks: v.fallbacks,
+            wifiMs: median(v.wifiMs),
+            telemetryMs: median(v.telemetryMs)
+        };
+    }
+    res.json(summary);
+});
+
+// 6. Latence réseau par étape, éventuellement à partir de ?since= (ms epoch)
+app.get('/api/window/net', (req, res) => {
+    const since = Number(req.query.since) || 0;
+    res.json(netHistory.filter(s => s.ts >= since));
+});
+
 app.listen(PORT, '0.0.0.0', () => {
     console.log(`Serveur prêt sur le port ${PORT}`);
 });
@@ -0,0 +1,51 @@
+// Codec MessagePack : aller-retour et corps hostiles (node --test).
+const test = require('node:test');
+const assert = require('node:assert');
+const { encode, decode } = require('../src/msgpack');
+
+test('aller-retour des types échangés avec l\'ESP32', () => {
+    const values = [
+        null, true, false, 0, 127, 128, 255, 256, 65535, 65536, 2 ** 32, 2 ** 40,
+        -1, -32, -33, -128, -129, -32768, -32769, -(2 ** 31) - 1,
+        1.5, -0.25, 1e300, '', 'a', 'é'.repeat(20), 'x'.repeat(300), 'y'.repeat(70000),
+        [], [1, 2, 3], Array.from({ length: 20 }, (_, i) => i),
+        { temp: 24.3, aqi: 12, isOpen: true, weather: { wind: 3.2, rain: null } },
+        Object.fromEntries(Array.from({ length: 20 }, (_, i) => ['k' + i, i])),
+    ];
+    for (const v of values) assert.deepStrictEqual(decode(encode(v)), v);
+});
+
+test('décodé comme le même corps en JSON', () => {
+    const body = { temp: 21.5, samples: [{ t: 1, temp: 20 }, { t: 2, temp: 21 }], tx: { sent: 3 } };
+    assert.deepStrictEqual(decode(encode(body)), JSON.parse(JSON.stringify(body)));
+});
+
+test('float32 ramené à sa précision', () => {
+    const b = Buffer.alloc(5);
+    b[0] = 0xca;
+    b.writeFloatBE(24.3, 1);
+    assert.strictEqual(decode(b), 24.3);
+});
+
+test('une clé __proto__ reste une propriété propre, comme avec JSON.parse', () => {
+    const hostile = '{"__proto__":{"isAdmin":true},"constructor":{"prototype":{"x":1}}}';
+    const fromJson = JSON.parse(hostile);
+    const o = decode(encode(fromJson));
+    assert.deepStrictEqual(Object.keys(o), ['__proto__', 'constructor']);
+    assert.strictEqual(o.isAdmin, undefined);
+    assert.strictEqual(Object.getPrototypeOf(o), Object.prototype);
+    assert.strictEqual({}.isAdmin, undefined);
+    assert.strictEqual({}.x, undefined);
+    assert.deepStrictEqual(o, fromJson);
+});
+
+test('corps tronqués, en trop ou trop imbriqués refusés', () => {
+    const full = encode({ temp: 20, name: 'fenetre' });
+    for (let n = 0; n < full.length; n++) assert.throws(() => decode(full.subarray(0, n)), /msgpack/);
+    assert.throws(() => decode(Buffer.concat([full, Buffer.from([0xc0])])), /octets en trop/);
+    assert.throws(() => decode(Buffer.from([0xdd, 0xff, 0xff, 0xff, 0xff])), /incomplet/);
+    assert.throws(() => decode(Buffer.from([0xdb, 0xff, 0xff, 0xff, 0xff, 0x61])), /incomplet/);
+    assert.throws(() => decode(Buffer.alloc(40, 0x91)), /imbrication/);
+    assert.throws(() => decode(Buffer.from([0xc1])), /non pris en charge/);
+    assert.throws(() => decode(Buffer.from([0xc7, 0x01, 0x00, 0x00])), /non pris en charge/);
+});
@@ -0,0 +1,298 @@
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <malloc.h>
+#include <random>
+#include <thread>
+
+#include "Arduino.h"
+#include "hal_native.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// --- Horloge ----------------------------------------------------------------
+
+namespace {
+class RealClock : public hal::Clock {
+public:
+    uint64_t micros() override {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot).count();
+    }
+    uint64_t epochUs() override {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+    void sleep(uint64_t us) override { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+    void spin() override { std::this_thread::yield(); }
+
+private:
+    const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+};
+
+RealClock realClock;
+std::atomic<hal::Clock*> currentClock{&realClock};
+std::mt19937 rng;
+}
+
+void hal::setClock(Clock* clock) {
+    currentClock = clock ? clock : &realClock;
+}
+
+hal::Clock& hal::clock() {
+    return *currentClock.load();
+}
+
+void hal::setFastClock(bool fast) {
+    static SimClock* fastClock = nullptr;
+    if (fast && !fastClock) fastClock = new SimClock(realClock.epochUs());
+    setClock(fast ? fastClock : nullptr);
+}
+
+unsigned long micros() {
+    return (unsigned long)hal::clock().micros();
+}
+
+unsigned long millis() {
+    return (unsigned long)(hal::clock().micros() / 1000);
+}
+
+void delay(unsigned long ms) {
+    hal::timerSleep((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    hal::timerSleep(us);
+}
+
+void yield() {
+    hal::clock().spin();
+    hal::timerPoll();
+}
+
+// Comme la newlib de l'ESP32 après la synchro NTP, time() suit l'horloge
+// installée : sous SimClock, les échantillons sont horodatés en temps simulé.
+extern "C" time_t time(time_t* out) noexcept {
+    time_t now = (time_t)(hal::clock().epochUs() / 1000000);
+    if (out) *out = now;
+    return now;
+}
+
+long random(long howbig) {
+    return howbig > 0 ? (long)(rng() % (unsigned long)howbig) : 0;
+}
+
+long random(long howsmall, long howbig) {
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+    rng.seed(seed);
+}
+
+// --- String -----------------------------------------------------------------
+
+std::string String::fromLong(long v, unsigned char base) {
+    if (base == 10) return std::to_string(v);
+    return v < 0 ? "-" + fromULong((unsigned long)-v, base) : fromULong((unsigned long)v, base);
+}
+
+std::string String::fromULong(unsigned long v, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    std::string out;
+    do {
+        int digit = v % base;
+        out.insert(out.begin(), (char)(digit < 10 ? '0' + digit : 'a' + digit - 10));
+        v /= base;
+    } while (v);
+    return out;
+}
+
+std::string String::fromDouble(double v, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    return buf;
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    if (_s.length() != s._s.length()) return false;
+    for (size_t i = 0; i < _s.length(); i++) {
+        if (tolower((unsigned char)_s[i]) != tolower((unsigned char)s._s[i])) return false;
+    }
+    return true;
+}
+
+bool String::endsWith(const String& s) const {
+    return _s.length() >= s._s.length() && _s.compare(_s.length() - s._s.length(), s._s.length(), s._s) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = _s.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& s, unsigned int from) const {
+    size_t pos = _s.find(s._s, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.length()) return String();
+    return String(_s.substr(from, to - from));
+}
+
+void String::trim() {
+    size_t begin = 0, end = _s.length();
+    while (begin < end && isspace((unsigned char)_s[begin])) begin++;
+    while (end > begin && isspace((unsigned char)_s[end - 1])) end--;
+    _s = _s.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+    for (char& c : _s) c = (char)tolower((unsigned char)c);
+}
+
+String operator+(const String& a, const String& b) { String r(a); r.concat(b); return r; }
+String operator+(const String& a, const char* b) { String r(a); r.concat(b); return r; }
+String operator+(const char* a, const String& b) { String r(a); r.concat(b); return r; }
+String operator+(const String& a, char b) { String r(a); r.concat(b); return r; }
+
+// --- Print / Stream -----------------------------------------------------------
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && write(buffer[n])) n++;
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    if ((size_t)len < sizeof(buf)) return write((const uint8_t*)buf, len);
+
+    std::string big(len + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&big[0], big.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)big.data(), len);
+}
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+        yield();
+    } while (millis() - start < _timeout);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String ret;
+    int c;
+    while ((c = timedRead()) >= 0) ret += (char)c;
+    return ret;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String ret;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) ret += (char)c;
+    return ret;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (!hal::quiet()) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+// --- ESP ----------------------------------------------------------------------
+
+void EspClass::restart() {
+    throw hal::Restart();
+}
+
+// Tas simulé : la taille d'un ESP32 sans PSRAM, diminuée de ce que le
+// programme a alloué depuis hal::begin() (malloc de glibc, arène unique pour
+// compter aussi les allocations de la tâche réseau), hors fichiers LittleFS. Le minimum n'est mis à
+// jour qu'aux lectures : c'est un minimum observé, pas un vrai plus bas.
+namespace {
+const uint32_t heapSize = 327680;
+const uint32_t heapFreeAtBoot = 250000;
+size_t heapBaseline = 0;
+uint32_t heapMinFree = heapFreeAtBoot;
+}
+
+void hal::heapReset() {
+    mallopt(M_ARENA_MAX, 1);
+    heapBaseline = mallinfo2().uordblks;
+    heapMinFree = heapFreeAtBoot;
+}
+
+uint32_t EspClass::getHeapSize() { return heapSize; }
+
+uint32_t EspClass::getFreeHeap() {
+    long used = (long)mallinfo2().uordblks - (long)heapBaseline - (long)hal::fsResidentBytes();
+    uint32_t free = (uint32_t)constrain((long)heapFreeAtBoot - used, 0L, (long)heapSize);
+    if (free < heapMinFree) heapMinFree = free;
+    return free;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return heapMinFree;
+}
+
+// Pas de fragmentation sur l'hôte : le plus gros bloc est borné comme sur l'ESP32.
+uint32_t EspClass::getMaxAllocHeap() { return std::min<uint32_t>(getFreeHeap(), 110592); }
+
+uint64_t EspClass::getEfuseMac() {
+    uint8_t mac[6];
+    hal::macAddress(mac);
+    uint64_t v = 0;
+    for (int i = 5; i >= 0; i--) v = (v << 8) | mac[i];
+    return v;
+}
+
+// --- IPAddress ------------------------------------------------------------------
+
+IPAddress::IPAddress(uint32_t addr) {
+    for (int i = 0; i < 4; i++) _addr[i] = (addr >> (8 * i)) & 0xFF;
+}
+
+IPAddress::operator uint32_t() const {
+    return (uint32_t)_addr[0] | ((uint32_t)_addr[1] << 8) | ((uint32_t)_addr[2] << 16) | ((uint32_t)_addr[3] << 24);
+}
+
+bool IPAddress::fromString(const char* address) {
+    unsigned a, b, c, d;
+    if (sscanf(address, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) return false;
+    _addr[0] = a; _addr[1] = b; _addr[2] = c; _addr[3] = d;
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _addr[0], _addr[1], _addr[2], _addr[3]);
+    return String(buf);
+}
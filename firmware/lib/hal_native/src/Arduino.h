@@ -0,0 +1,173 @@
+// Cœur Arduino minimal pour l'environnement `native`.
+// Seul ce que le firmware utilise est reproduit, avec la sémantique de l'ESP32.
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <algorithm>
+
+#include "IPAddress.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define IRAM_ATTR
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+// time() suit l'horloge de la HAL (réelle ou simulée) : juste dès le boot.
+inline void configTime(long gmtOffset, int daylightOffset, const char* server1, const char* server2 = nullptr,
+                       const char* server3 = nullptr) {
+    (void)gmtOffset; (void)daylightOffset; (void)server1; (void)server2; (void)server3;
+}
+
+class String {
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+    explicit String(int v, unsigned char base = 10) : _s(fromLong(v, base)) {}
+    explicit String(unsigned int v, unsigned char base = 10) : _s(fromULong(v, base)) {}
+    explicit String(long v, unsigned char base = 10) : _s(fromLong(v, base)) {}
+    explicit String(unsigned long v, unsigned char base = 10) : _s(fromULong(v, base)) {}
+    explicit String(float v, unsigned int decimals = 2) : _s(fromDouble(v, decimals)) {}
+    explicit String(double v, unsigned int decimals = 2) : _s(fromDouble(v, decimals)) {}
+
+    String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.length(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    char charAt(unsigned int i) const { return i < _s.length() ? _s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+
+    bool concat(const char* s) { if (s) _s += s; return true; }
+    bool concat(const char* s, unsigned int n) { if (s) _s.append(s, n); return true; }
+    bool concat(const String& s) { _s += s._s; return true; }
+    bool concat(char c) { _s += c; return true; }
+    String& operator+=(const char* s) { concat(s); return *this; }
+    String& operator+=(const String& s) { concat(s); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool equals(const String& s) const { return _s == s._s; }
+    bool equals(const char* s) const { return _s == (s ? s : ""); }
+    bool equalsIgnoreCase(const String& s) const;
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+    bool startsWith(const String& s) const { return _s.compare(0, s._s.length(), s._s) == 0; }
+    bool endsWith(const String& s) const;
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& s, unsigned int from = 0) const;
+    String substring(unsigned int from) const { return substring(from, _s.length()); }
+    String substring(unsigned int from, unsigned int to) const;
+    void trim();
+    void toLowerCase();
+
+    long toInt() const { return std::strtol(_s.c_str(), nullptr, 10); }
+    float toFloat() const { return std::strtof(_s.c_str(), nullptr); }
+
+    const std::string& str() const { return _s; }
+
+private:
+    static std::string fromLong(long v, unsigned char base);
+    static std::string fromULong(unsigned long v, unsigned char base);
+    static std::string fromDouble(double v, unsigned int decimals);
+
+    std::string _s;
+};
+
+String operator+(const String& a, const String& b);
+String operator+(const String& a, const char* b);
+String operator+(const char* a, const String& b);
+String operator+(const String& a, char b);
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    virtual void flush() {}
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v, int base = 10) { return print(String(v, (unsigned char)base)); }
+    size_t print(unsigned int v, int base = 10) { return print(String(v, (unsigned char)base)); }
+    size_t print(long v, int base = 10) { return print(String(v, (unsigned char)base)); }
+    size_t print(unsigned long v, int base = 10) { return print(String(v, (unsigned char)base)); }
+    size_t print(double v, int digits = 2) { return print(String(v, (unsigned int)digits)); }
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    // Virtuelle ici (contrairement au cœur Arduino) pour que les clients réseau
+    // simulés rendent la main dès que la connexion est fermée.
+    virtual int timedRead();
+    unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    [[noreturn]] void restart();
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint64_t getEfuseMac();
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
@@ -0,0 +1,30 @@
+#include "ESP32Servo.h"
+#include "hal_native.h"
+
+int Servo::attach(int pin, int minUs, int maxUs) {
+    _pin = pin;
+    _minUs = minUs;
+    _maxUs = maxUs;
+    return 0;
+}
+
+void Servo::write(int value) {
+    // Même convention que ESP32Servo : < 500 est un angle, sinon des µs.
+    if (value < 500) {
+        value = constrain(value, 0, 180);
+        value = _minUs + (long)value * (_maxUs - _minUs) / 180;
+    }
+    writeMicroseconds(value);
+}
+
+void Servo::writeMicroseconds(int us) {
+    if (!attached()) return;
+    _us = constrain(us, _minUs, _maxUs);
+    hal::stats().servoWrites++;
+    hal::stats().servoAngle = read();
+}
+
+int Servo::read() const {
+    if (_maxUs == _minUs) return 0;
+    return (int)(((long)(_us - _minUs) * 180 + (_maxUs - _minUs) / 2) / (_maxUs - _minUs));
+}
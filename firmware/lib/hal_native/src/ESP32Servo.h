@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Servo simulé : mémorise la dernière consigne et compte les écritures
+// (voir hal::stats()).
+class Servo {
+public:
+    void setPeriodHertz(int hertz) { _hertz = hertz; }
+    int attach(int pin, int minUs = 544, int maxUs = 2400);
+    void detach() { _pin = -1; }
+    bool attached() const { return _pin >= 0; }
+    void write(int value);
+    void writeMicroseconds(int us);
+    int read() const;
+    int readMicroseconds() const { return _us; }
+
+private:
+    int _pin = -1;
+    int _hertz = 50;
+    int _minUs = 544;
+    int _maxUs = 2400;
+    int _us = 0;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Arduino.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+namespace fs {
+
+// Fichier simulé en mémoire, avec les modes de fopen() ("r", "w", "a", "r+", "w+", "a+").
+class File : public Stream {
+public:
+    File() {}
+    File(const std::string& name, std::shared_ptr<std::vector<uint8_t>> data, const char* mode);
+
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buf, size_t size);
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const { return _pos; }
+    size_t size() const { return _data ? _data->size() : 0; }
+    void close() { _data.reset(); }
+    const char* name() const { return _name.c_str(); }
+    operator bool() const { return (bool)_data; }
+
+private:
+    std::string _name;
+    std::shared_ptr<std::vector<uint8_t>> _data;
+    size_t _pos = 0;
+    bool _readable = false;
+    bool _writable = false;
+    bool _append = false;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) { return open(path.c_str(), mode, create); }
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+};
+
+}  // namespace fs
+
+using fs::FS;
+using fs::File;
@@ -0,0 +1,290 @@
+#include "HTTPClient.h"
+#include "hal_native.h"
+
+HTTPClient::HTTPClient() {}
+
+HTTPClient::~HTTPClient() {
+    // Comme sur l'ESP32 : détruire le client HTTP ferme le socket.
+    if (_client) _client->stop();
+}
+
+bool HTTPClient::begin(String url) {
+    bool secure = url.startsWith("https:");
+    if (!secure && !url.startsWith("http:")) return false;
+    if (_client && _client != _ownClient.get()) { _canReuse = false; end(); }
+    if (!_ownClient || _secure != secure) {
+        if (_ownClient) _ownClient->stop();
+        if (secure) {
+            WiFiClientSecure* tls = new WiFiClientSecure();
+            tls->setInsecure();
+            _ownClient.reset(tls);
+        } else {
+            _ownClient.reset(new WiFiClient());
+        }
+    }
+    _client = _ownClient.get();
+    return beginInternal(url, secure);
+}
+
+bool HTTPClient::begin(WiFiClient& client, String url) {
+    bool secure = url.startsWith("https:");
+    if (!secure && !url.startsWith("http:")) return false;
+    _client = &client;
+    return beginInternal(url, secure);
+}
+
+bool HTTPClient::beginInternal(String url, bool secure) {
+    clear();
+    _secure = secure;
+    url = url.substring(url.indexOf("://") + 3);
+
+    int slash = url.indexOf('/');
+    String hostPort = slash < 0 ? url : url.substring(0, slash);
+    String uri = slash < 0 ? String("/") : url.substring(slash);
+
+    String host = hostPort;
+    uint16_t port = secure ? 443 : 80;
+    int colon = hostPort.indexOf(':');
+    if (colon >= 0) {
+        host = hostPort.substring(0, colon);
+        port = (uint16_t)hostPort.substring(colon + 1).toInt();
+    }
+
+    // Changement de serveur : la connexion ouverte ne peut pas servir.
+    if (_client && _client->connected() && (host != _host || port != _port)) _client->stop();
+    _host = host;
+    _port = port;
+    _uri = uri;
+    return true;
+}
+
+void HTTPClient::end() {
+    disconnect(false);
+    clear();
+}
+
+void HTTPClient::disconnect(bool preserveClient) {
+    if (!connected()) return;
+    while (_client->available() > 0) _client->read();
+    if (_reuse && _canReuse) return;  // socket gardé ouvert pour la requête suivante
+    _client->stop();
+    if (!preserveClient && _client != _ownClient.get()) _client = nullptr;
+}
+
+bool HTTPClient::connected() {
+    if (!_client) return false;
+    return _client->available() > 0 || _client->connected();
+}
+
+void HTTPClient::clear() {
+    _returnCode = 0;
+    _size = -1;
+    _headers = "";
+}
+
+bool HTTPClient::connect() {
+    if (connected()) {
+        while (_client->available() > 0) _client->read();
+        return true;
+    }
+    if (!_client) return false;
+    if (!_client->connect(_host.c_str(), _port, _connectTimeout)) return false;
+    _client->setTimeout(_tcpTimeout);
+    return connected();
+}
+
+void HTTPClient::addHeader(const String& name, const String& value, bool first, bool replace) {
+    // Ces en-têtes sont gérés par le client lui-même.
+    if (name.equalsIgnoreCase("Connection") || name.equalsIgnoreCase("User-Agent") ||
+        name.equalsIgnoreCase("Host")) return;
+
+    String headerLine = name + ": ";
+    if (replace) {
+        int headerStart = _headers.indexOf(headerLine);
+        if (headerStart != -1 && (headerStart == 0 || _headers[headerStart - 1] == '\n')) {
+            int headerEnd = _headers.indexOf('\n', headerStart);
+            _headers = _headers.substring(0, headerStart) + _headers.substring(headerEnd + 1);
+        }
+    }
+    headerLine += value;
+    headerLine += "\r\n";
+    if (first) _headers = headerLine + _headers;
+    else _headers += headerLine;
+}
+
+void HTTPClient::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    _currentHeaders.clear();
+    for (size_t i = 0; i < headerKeysCount; i++) _currentHeaders.push_back({String(headerKeys[i]), String("")});
+}
+
+String HTTPClient::header(const char* name) {
+    for (const Header& h : _currentHeaders) {
+        if (h.key.equalsIgnoreCase(name)) return h.value;
+    }
+    return String();
+}
+
+bool HTTPClient::hasHeader(const char* name) {
+    for (const Header& h : _currentHeaders) {
+        if (h.key.equalsIgnoreCase(name) && h.value.length() > 0) return true;
+    }
+    return false;
+}
+
+int HTTPClient::GET() {
+    return sendRequest("GET");
+}
+
+int HTTPClient::POST(uint8_t* payload, size_t size) {
+    return sendRequest("POST", payload, size);
+}
+
+int HTTPClient::POST(String payload) {
+    return POST((uint8_t*)payload.c_str(), payload.length());
+}
+
+int HTTPClient::sendRequest(const char* type, String payload) {
+    return sendRequest(type, (uint8_t*)payload.c_str(), payload.length());
+}
+
+int HTTPClient::sendRequest(const char* type, uint8_t* payload, size_t size) {
+    int code = request(type, payload, size);
+    hal::Stats& stats = hal::stats();
+    stats.httpRequests++;
+    if (code <= 0) stats.httpFailures++;
+    else if (code >= 400) stats.httpErrors++;
+    return code;
+}
+
+int HTTPClient::request(const char* type, uint8_t* payload, size_t size) {
+    if (!connect()) return returnError(HTTPC_ERROR_CONNECTION_REFUSED);
+    if (payload && size > 0) addHeader("Content-Length", String((unsigned int)size));
+
+    String header = String(type) + " " + _uri + (_useHTTP10 ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n");
+    header += "Host: " + _host;
+    if (_port != 80 && _port != 443) header += ":" + String((unsigned int)_port);
+    header += "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: ";
+    header += _reuse ? "keep-alive\r\n" : "close\r\n";
+    if (!_useHTTP10) header += "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n";
+    header += _headers + "\r\n";
+
+    if (_client->write((const uint8_t*)header.c_str(), header.length()) != header.length()) {
+        return returnError(HTTPC_ERROR_SEND_HEADER_FAILED);
+    }
+    if (payload && size > 0 && _client->write(payload, size) != size) {
+        return returnError(HTTPC_ERROR_SEND_PAYLOAD_FAILED);
+    }
+    return returnError(handleHeaderResponse());
+}
+
+int HTTPClient::handleHeaderResponse() {
+    if (!connected()) return HTTPC_ERROR_NOT_CONNECTED;
+
+    _canReuse = _reuse;
+    _returnCode = 0;
+    _size = -1;
+    _chunked = false;
+    for (Header& h : _currentHeaders) h.value = "";
+
+    unsigned long lastDataTime = millis();
+    while (connected()) {
+        if (_client->available() <= 0) {
+            if (millis() - lastDataTime > _tcpTimeout) return HTTPC_ERROR_READ_TIMEOUT;
+            yield();
+            continue;
+        }
+        String headerLine = _client->readStringUntil('\n');
+        headerLine.trim();
+        lastDataTime = millis();
+
+        if (headerLine.startsWith("HTTP/1.")) {
+            if (_canReuse) _canReuse = headerLine[7] != '0';
+            _returnCode = headerLine.substring(9, headerLine.indexOf(' ', 9)).toInt();
+        } else if (headerLine.indexOf(':') > 0) {
+            int sep = headerLine.indexOf(':');
+            String headerName = headerLine.substring(0, sep);
+            String headerValue = headerLine.substring(sep + 1);
+            headerValue.trim();
+
+            if (headerName.equalsIgnoreCase("Content-Length")) _size = headerValue.toInt();
+            if (headerName.equalsIgnoreCase("Connection") && headerValue.indexOf("close") >= 0 &&
+                headerValue.indexOf("keep-alive") < 0) _canReuse = false;
+            if (headerName.equalsIgnoreCase("Transfer-Encoding")) _chunked = headerValue.equalsIgnoreCase("chunked");
+            for (Header& h : _currentHeaders) {
+                if (h.key.equalsIgnoreCase(headerName)) h.value = headerValue;
+            }
+        }
+
+        if (headerLine.length() == 0) {
+            if (_returnCode) return _returnCode;
+            return HTTPC_ERROR_NO_HTTP_SERVER;
+        }
+    }
+    return HTTPC_ERROR_CONNECTION_LOST;
+}
+
+int HTTPClient::returnError(int error) {
+    if (error < 0 && connected()) _client->stop();
+    return error;
+}
+
+WiFiClient& HTTPClient::getStream() {
+    static WiFiClient disconnected;
+    return connected() ? *_client : disconnected;
+}
+
+WiFiClient* HTTPClient::getStreamPtr() {
+    return connected() ? _client : nullptr;
+}
+
+String HTTPClient::getString() {
+    String payload;
+    if (!connected()) return payload;
+    if (_size > 0) payload.reserve(_size);
+
+    char buff[256];
+    if (_chunked) {
+        for (;;) {
+            String chunkHeader = _client->readStringUntil('\n');
+            chunkHeader.trim();
+            long len = strtol(chunkHeader.c_str(), nullptr, 16);
+            if (len <= 0) { _client->readStringUntil('\n'); break; }
+            while (len > 0) {
+                size_t n = _client->readBytes(buff, min((long)sizeof(buff), len));
+                if (n == 0) break;
+                payload.concat(buff, n);
+                len -= n;
+            }
+            _client->readStringUntil('\n');
+            if (!connected()) break;
+        }
+    } else {
+        int remaining = _size;
+        while (connected() && (remaining > 0 || _size < 0)) {
+            size_t want = _size < 0 ? sizeof(buff) : min((int)sizeof(buff), remaining);
+            size_t n = _client->readBytes(buff, want);
+            if (n == 0) break;
+            payload.concat(buff, n);
+            remaining -= n;
+        }
+    }
+    end();
+    return payload;
+}
+
+String HTTPClient::errorToString(int error) {
+    switch (error) {
+    case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+    case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+    case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+    case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+    case HTTPC_ERROR_NO_STREAM: return "no stream";
+    case HTTPC_ERROR_NO_HTTP_SERVER: return "no HTTP server";
+    case HTTPC_ERROR_TOO_LESS_RAM: return "too less ram";
+    case HTTPC_ERROR_ENCODING: return "Transfer-Encoding not supported";
+    case HTTPC_ERROR_STREAM_WRITE: return "Stream write error";
+    case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+    default: return String();
+    }
+}
@@ -0,0 +1,97 @@
+// Client HTTP/1.1 minimal, même API et même gestion de la connexion
+// (setReuse, end() qui garde le socket ouvert) que le HTTPClient de l'ESP32.
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+#include "WiFiClient.h"
+#include "WiFiClientSecure.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_NO_STREAM           (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER      (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM        (-8)
+#define HTTPC_ERROR_ENCODING            (-9)
+#define HTTPC_ERROR_STREAM_WRITE        (-10)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT (5000)
+
+typedef enum {
+    HTTP_CODE_OK = 200,
+    HTTP_CODE_NO_CONTENT = 204,
+    HTTP_CODE_NOT_MODIFIED = 304,
+    HTTP_CODE_BAD_REQUEST = 400,
+    HTTP_CODE_NOT_FOUND = 404,
+    HTTP_CODE_TOO_MANY_REQUESTS = 429,
+    HTTP_CODE_INTERNAL_SERVER_ERROR = 500,
+    HTTP_CODE_SERVICE_UNAVAILABLE = 503
+} t_http_codes;
+
+class HTTPClient {
+public:
+    HTTPClient();
+    ~HTTPClient();
+
+    bool begin(String url);
+    bool begin(WiFiClient& client, String url);
+    void end();
+    bool connected();
+
+    void setReuse(bool reuse) { _reuse = reuse; }
+    void useHTTP10(bool usehttp10 = true) { _useHTTP10 = usehttp10; }
+    void setTimeout(uint16_t timeout) { _tcpTimeout = timeout; }
+    void setConnectTimeout(int32_t connectTimeout) { _connectTimeout = connectTimeout; }
+
+    void addHeader(const String& name, const String& value, bool first = false, bool replace = true);
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+    String header(const char* name);
+    bool hasHeader(const char* name);
+
+    int GET();
+    int POST(uint8_t* payload, size_t size);
+    int POST(String payload);
+    int sendRequest(const char* type, String payload);
+    int sendRequest(const char* type, uint8_t* payload = nullptr, size_t size = 0);
+
+    int getSize() { return _size; }
+    WiFiClient& getStream();
+    WiFiClient* getStreamPtr();
+    String getString();
+
+    static String errorToString(int error);
+
+private:
+    struct Header { String key; String value; };
+
+    bool beginInternal(String url, bool secure);
+    int request(const char* type, uint8_t* payload, size_t size);
+    bool connect();
+    void disconnect(bool preserveClient = false);
+    void clear();
+    int handleHeaderResponse();
+    int returnError(int error);
+
+    WiFiClient* _client = nullptr;
+    std::unique_ptr<WiFiClient> _ownClient;
+    bool _secure = false;
+    String _host;
+    uint16_t _port = 80;
+    String _uri;
+    String _headers;
+    std::vector<Header> _currentHeaders;
+
+    bool _reuse = true;
+    bool _canReuse = false;
+    bool _useHTTP10 = false;
+    bool _chunked = false;
+    uint16_t _tcpTimeout = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;
+    int32_t _connectTimeout = -1;
+    int _returnCode = 0;
+    int _size = -1;
+};
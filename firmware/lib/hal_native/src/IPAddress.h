@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+class String;
+
+class IPAddress {
+public:
+    IPAddress() : _addr{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr{a, b, c, d} {}
+    explicit IPAddress(uint32_t addr);
+
+    uint8_t operator[](int i) const { return _addr[i]; }
+    uint8_t& operator[](int i) { return _addr[i]; }
+    operator uint32_t() const;
+    bool operator==(const IPAddress& o) const { return (uint32_t)*this == (uint32_t)o; }
+    bool operator!=(const IPAddress& o) const { return !(*this == o); }
+
+    bool fromString(const char* address);
+    String toString() const;
+
+private:
+    uint8_t _addr[4];
+};
@@ -0,0 +1,132 @@
+#include <map>
+#include <mutex>
+
+#include "LittleFS.h"
+#include "hal_native.h"
+
+fs::LittleFSFS LittleFS;
+
+namespace {
+typedef std::shared_ptr<std::vector<uint8_t>> Data;
+std::map<std::string, Data> files;
+std::mutex filesLock;
+const size_t partitionSize = 0x160000;  // partition "spiffs" de default.csv
+}
+
+size_t hal::fsResidentBytes() {
+    std::lock_guard<std::mutex> guard(filesLock);
+    size_t bytes = 0;
+    for (const auto& f : files) bytes += f.second->capacity();
+    return bytes;
+}
+
+void hal::fsFormat() {
+    std::lock_guard<std::mutex> guard(filesLock);
+    files.clear();
+}
+
+// --- File ---------------------------------------------------------------------
+
+fs::File::File(const std::string& name, std::shared_ptr<std::vector<uint8_t>> data, const char* mode)
+    : _name(name), _data(data) {
+    _readable = mode[0] == 'r' || strchr(mode, '+');
+    _writable = mode[0] != 'r' || strchr(mode, '+');
+    _append = mode[0] == 'a';
+    if (_append) _pos = _data->size();
+}
+
+size_t fs::File::write(const uint8_t* buf, size_t size) {
+    if (!_data || !_writable) return 0;
+    if (_append) _pos = _data->size();
+    if (_pos + size > _data->size()) _data->resize(_pos + size);
+    memcpy(_data->data() + _pos, buf, size);
+    _pos += size;
+    hal::stats().flashBytes += size;
+    return size;
+}
+
+int fs::File::available() {
+    return _data && _readable ? (int)(_data->size() - std::min(_pos, _data->size())) : 0;
+}
+
+int fs::File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int fs::File::peek() {
+    return available() > 0 ? (*_data)[_pos] : -1;
+}
+
+size_t fs::File::read(uint8_t* buf, size_t size) {
+    size_t n = std::min<size_t>(size, available());
+    if (n) memcpy(buf, _data->data() + _pos, n);
+    _pos += n;
+    return n;
+}
+
+bool fs::File::seek(uint32_t pos, SeekMode mode) {
+    if (!_data) return false;
+    long target = mode == SeekSet ? (long)pos : mode == SeekCur ? (long)_pos + pos : (long)_data->size() + pos;
+    if (target < 0 || (size_t)target > _data->size()) return false;
+    _pos = (size_t)target;
+    return true;
+}
+
+// --- FS -------------------------------------------------------------------------
+
+fs::File fs::FS::open(const char* path, const char* mode, bool create) {
+    std::lock_guard<std::mutex> guard(filesLock);
+    auto it = files.find(path);
+    if (mode[0] == 'r') {
+        if (it == files.end()) {
+            if (!create) return File();
+            it = files.emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+        }
+        return File(path, it->second, mode);
+    }
+    if (it == files.end()) it = files.emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+    else if (mode[0] == 'w') it->second->clear();
+    return File(path, it->second, mode);
+}
+
+bool fs::FS::exists(const char* path) {
+    std::lock_guard<std::mutex> guard(filesLock);
+    return files.count(path) > 0;
+}
+
+bool fs::FS::remove(const char* path) {
+    std::lock_guard<std::mutex> guard(filesLock);
+    return files.erase(path) > 0;
+}
+
+bool fs::FS::rename(const char* from, const char* to) {
+    std::lock_guard<std::mutex> guard(filesLock);
+    auto it = files.find(from);
+    if (it == files.end()) return false;
+    Data data = it->second;
+    files.erase(it);
+    files[to] = data;
+    return true;
+}
+
+bool fs::LittleFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+    (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+    return true;
+}
+
+bool fs::LittleFSFS::format() {
+    hal::fsFormat();
+    return true;
+}
+
+size_t fs::LittleFSFS::totalBytes() {
+    return partitionSize;
+}
+
+size_t fs::LittleFSFS::usedBytes() {
+    std::lock_guard<std::mutex> guard(filesLock);
+    size_t used = 0;
+    for (const auto& f : files) used += (f.second->size() + 4095) / 4096 * 4096;
+    return used;
+}
@@ -0,0 +1,53 @@
+#include <memory>
+
+#include "NimBLEDevice.h"
+#include "hal_native.h"
+
+namespace {
+std::vector<std::unique_ptr<NimBLECharacteristic>> characteristics;
+std::vector<std::unique_ptr<NimBLEService>> services;
+std::unique_ptr<NimBLEServer> server;
+NimBLEAdvertising advertising;
+}
+
+NimBLECharacteristic* NimBLEService::createCharacteristic(const char* uuid, uint32_t properties) {
+    characteristics.emplace_back(new NimBLECharacteristic(uuid, (uint16_t)properties));
+    return characteristics.back().get();
+}
+
+NimBLEService* NimBLEServer::createService(const char* uuid) {
+    services.emplace_back(new NimBLEService(uuid));
+    return services.back().get();
+}
+
+void NimBLEDevice::init(const std::string& deviceName) {
+    (void)deviceName;
+}
+
+void NimBLEDevice::deinit(bool clearAll) {
+    if (!clearAll) return;
+    characteristics.clear();
+    services.clear();
+    server.reset();
+}
+
+NimBLEServer* NimBLEDevice::createServer() {
+    if (!server) server.reset(new NimBLEServer());
+    return server.get();
+}
+
+NimBLEAdvertising* NimBLEDevice::getAdvertising() {
+    return &advertising;
+}
+
+bool hal::bleWrite(const char* uuid, const std::string& value) {
+    // Dernière caractéristique créée pour cet UUID : setup() peut être rejoué après un restart.
+    for (auto it = characteristics.rbegin(); it != characteristics.rend(); ++it) {
+        NimBLECharacteristic* chr = it->get();
+        if (chr->getUUID() != uuid) continue;
+        chr->setValue(value);
+        if (chr->getCallbacks()) chr->getCallbacks()->onWrite(chr);
+        return true;
+    }
+    return false;
+}
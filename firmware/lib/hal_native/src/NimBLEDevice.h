@@ -0,0 +1,87 @@
+// Pile BLE simulée : même surface que NimBLE-Arduino 1.4 pour ce que le
+// firmware utilise. Les écritures GATT sont injectées par hal::bleWrite().
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+namespace NIMBLE_PROPERTY {
+enum : uint16_t {
+    BROADCAST = 0x0001,
+    READ = 0x0002,
+    WRITE_NR = 0x0004,
+    WRITE = 0x0008,
+    NOTIFY = 0x0010,
+    INDICATE = 0x0020
+};
+}
+
+class NimBLECharacteristic;
+
+class NimBLECharacteristicCallbacks {
+public:
+    virtual ~NimBLECharacteristicCallbacks() {}
+    virtual void onRead(NimBLECharacteristic* pCharacteristic) { (void)pCharacteristic; }
+    virtual void onWrite(NimBLECharacteristic* pCharacteristic) { (void)pCharacteristic; }
+};
+
+class NimBLECharacteristic {
+public:
+    NimBLECharacteristic(const std::string& uuid, uint16_t properties) : _uuid(uuid), _properties(properties) {}
+    const std::string& getUUID() const { return _uuid; }
+    std::string getValue() const { return _value; }
+    void setValue(const std::string& value) { _value = value; }
+    void setCallbacks(NimBLECharacteristicCallbacks* pCallbacks) { _callbacks = pCallbacks; }
+    NimBLECharacteristicCallbacks* getCallbacks() const { return _callbacks; }
+    void notify() {}
+
+private:
+    std::string _uuid;
+    uint16_t _properties;
+    std::string _value;
+    NimBLECharacteristicCallbacks* _callbacks = nullptr;
+};
+
+class NimBLEService {
+public:
+    explicit NimBLEService(const std::string& uuid) : _uuid(uuid) {}
+    NimBLECharacteristic* createCharacteristic(const char* uuid,
+                                               uint32_t properties = NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE);
+    bool start() { return true; }
+
+private:
+    std::string _uuid;
+};
+
+class NimBLEServer {
+public:
+    NimBLEService* createService(const char* uuid);
+};
+
+class NimBLEAdvertising {
+public:
+    void addServiceUUID(const char* uuid) { (void)uuid; }
+    bool start() { _advertising = true; return true; }
+    bool stop() { _advertising = false; return true; }
+    bool isAdvertising() const { return _advertising; }
+
+private:
+    bool _advertising = false;
+};
+
+class NimBLEDevice {
+public:
+    static void init(const std::string& deviceName);
+    static void deinit(bool clearAll = false);
+    static NimBLEServer* createServer();
+    static NimBLEAdvertising* getAdvertising();
+};
+
+// Alias de compatibilité fournis par NimBLE-Arduino.
+#define BLEDevice NimBLEDevice
+#define BLEServer NimBLEServer
+#define BLEService NimBLEService
+#define BLECharacteristic NimBLECharacteristic
+#define BLECharacteristicCallbacks NimBLECharacteristicCallbacks
+#define BLEAdvertising NimBLEAdvertising
@@ -0,0 +1,148 @@
+#include <map>
+#include <mutex>
+
+#include "Preferences.h"
+#include "hal_native.h"
+
+namespace {
+std::map<std::string, std::map<std::string, std::string>> store;
+std::recursive_mutex storeLock;  // la tâche réseau a ses propres espaces de noms
+}
+
+void hal::nvsSet(const std::string& ns, const std::string& key, const std::string& value) {
+    std::lock_guard<std::recursive_mutex> guard(storeLock);
+    store[ns][key] = value;
+}
+
+void hal::nvsLoad(const std::string& spec) {
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        size_t dot = item.find('.');
+        size_t eq = item.find('=');
+        if (dot != std::string::npos && eq != std::string::npos && dot < eq) {
+            nvsSet(item.substr(0, dot), item.substr(dot + 1, eq - dot - 1), item.substr(eq + 1));
+        }
+        pos = end + 1;
+    }
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition) {
+    (void)partition;
+    if (_started) return false;
+    _ns = name;
+    _readOnly = readOnly;
+    _started = true;
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+bool Preferences::clear() {
+    std::lock_guard<std::recursive_mutex> guard(storeLock);
+    if (!_started || _readOnly) return false;
+    store[_ns].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    std::lock_guard<std::recursive_mutex> guard(storeLock);
+    if (!_started || _readOnly) return false;
+    return store[_ns].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return get(key) != nullptr;
+}
+
+bool Preferences::put(const char* key, const std::string& value) {
+    std::lock_guard<std::recursive_mutex> guard(storeLock);
+    if (!_started || _readOnly) return false;
+    store[_ns][key] = value;
+    return true;
+}
+
+const std::string* Preferences::get(const char* key) {
+    std::lock_guard<std::recursive_mutex> guard(storeLock);
+    if (!_started) return nullptr;
+    auto ns = store.find(_ns);
+    if (ns == store.end()) return nullptr;
+    auto it = ns->second.find(key);
+    return it == ns->second.end() ? nullptr : &it->second;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return put(key, value.str()) ? value.length() : 0;
+}
+
+size_t Preferences::putFloat(const char* key, float value) {
+    return put(key, std::string((const char*)&value, sizeof(value))) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    return put(key, std::to_string(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return put(key, std::to_string(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return put(key, std::to_string(value)) ? sizeof(value) : 0;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    return putUChar(key, value ? 1 : 0);
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    return put(key, std::string((const char*)value, len)) ? len : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    const std::string* v = get(key);
+    return v ? String(*v) : defaultValue;
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    const std::string* v = get(key);
+    if (!v) return defaultValue;
+    // Valeur binaire écrite par putFloat(), ou texte venant de HAL_NVS.
+    if (v->size() == sizeof(float)) { float f; memcpy(&f, v->data(), sizeof(f)); return f; }
+    return strtof(v->c_str(), nullptr);
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    const std::string* v = get(key);
+    return v ? (int32_t)strtol(v->c_str(), nullptr, 10) : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    const std::string* v = get(key);
+    return v ? (uint32_t)strtoul(v->c_str(), nullptr, 10) : defaultValue;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    const std::string* v = get(key);
+    return v ? (uint8_t)strtoul(v->c_str(), nullptr, 10) : defaultValue;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    return getUChar(key, defaultValue ? 1 : 0) != 0;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    const std::string* v = get(key);
+    return v ? v->size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    const std::string* v = get(key);
+    if (!v || v->size() > maxLen) return 0;
+    memcpy(buf, v->data(), v->size());
+    return v->size();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Arduino.h"
+
+// NVS simulée : espaces de noms clé/valeur en mémoire, pré-remplissables
+// par hal::nvsSet() ou la variable d'environnement HAL_NVS.
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partition = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putString(const char* key, const String& value);
+    size_t putFloat(const char* key, float value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putBool(const char* key, bool value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+
+    String getString(const char* key, const String& defaultValue = String());
+    float getFloat(const char* key, float defaultValue = NAN);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    bool getBool(const char* key, bool defaultValue = false);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+private:
+    bool put(const char* key, const std::string& value);
+    const std::string* get(const char* key);
+
+    std::string _ns;
+    bool _started = false;
+    bool _readOnly = false;
+};
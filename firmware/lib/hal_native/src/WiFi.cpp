@@ -0,0 +1,315 @@
+#include <atomic>
+
+#include "WiFi.h"
+#include "esp_wifi.h"
+#include "hal_native.h"
+
+WiFiClass WiFi;
+
+namespace {
+std::string ssid;
+bool associated = false;
+bool link = true;
+uint8_t mac[6] = {0x24, 0x6f, 0x28, 0x00, 0x00, 0x01};
+uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+IPAddress staticIp;      // WiFi.config() : association sans DHCP
+bool reachable = false;  // false : canal ou BSSID imposés qui ne sont pas ceux du point d'accès
+uint64_t linkAt = 0;     // association au point d'accès, avant le bail (micros() de la HAL)
+uint64_t readyAt = 0;    // fin de l'association en cours, bail compris
+
+// Ordres de grandeur d'une association ESP32 : scan actif canal par canal
+// jusqu'à celui du point d'accès (scan rapide), authentification et 4-way
+// handshake, puis bail DHCP. Avec canal et BSSID connus, seul le canal
+// imposé est sondé. HAL_DHCP_MS simule un serveur DHCP lent.
+const uint32_t SCAN_CHANNEL_MS = 120;
+const uint32_t ASSOC_MS = 80;
+const uint32_t DHCP_MS = 300;
+
+uint32_t dhcpMs() {
+    const char* env = getenv("HAL_DHCP_MS");
+    return env ? (uint32_t)atoi(env) : DHCP_MS;
+}
+
+// Modem-sleep : réglage par défaut de l'IDF (réveil à chaque DTIM du point
+// d'accès, HAL_DTIM beacons). Après un échange, la station reste éveillée
+// RADIO_ACTIVE_US avant de se rendormir.
+const uint64_t BEACON_US = 102400;
+const uint64_t RADIO_ACTIVE_US = 50000;
+std::atomic<wifi_ps_type_t> powerSave{WIFI_PS_MIN_MODEM};
+std::atomic<uint16_t> listenInterval{0};  // configuré (esp_wifi_set_config)
+std::atomic<uint16_t> assocListen{0};     // annoncé à l'association en cours
+std::atomic<uint64_t> lastTraffic{0};
+
+uint32_t dtimPeriod() {
+    const char* env = getenv("HAL_DTIM");
+    int n = env ? atoi(env) : 1;
+    return n >= 1 && n <= 10 ? n : 1;
+}
+
+int32_t apChannel() {
+    const char* env = getenv("HAL_WIFI_CHANNEL");
+    int32_t ch = env ? atoi(env) : 6;
+    return ch >= 1 && ch <= 13 ? ch : 6;
+}
+
+// Canal et BSSID imposés par le dernier begin(), repris par esp_wifi_connect().
+int32_t hintChannel = 0;
+uint8_t hintBssid[6];
+bool hasBssidHint = false;
+
+// Association avec la configuration courante ; l'intervalle d'écoute part
+// dans la requête d'association et vaut jusqu'à la suivante.
+void associate() {
+    associated = !ssid.empty();
+    assocListen = listenInterval.load();
+    uint32_t ms;
+    if (hintChannel > 0) {
+        reachable = hintChannel == apChannel() && (!hasBssidHint || memcmp(hintBssid, bssid, 6) == 0);
+        ms = SCAN_CHANNEL_MS + ASSOC_MS;
+    } else {
+        reachable = true;
+        ms = SCAN_CHANNEL_MS * apChannel() + ASSOC_MS;
+    }
+    uint64_t now = hal::clock().micros();
+    linkAt = now + ms * 1000ULL;
+    if (staticIp == IPAddress()) ms += dhcpMs();
+    readyAt = now + ms * 1000ULL;
+}
+}
+
+void hal::setLink(bool up) {
+    link = up;
+}
+
+bool hal::linkUp() {
+    return link && associated;
+}
+
+void hal::macAddress(uint8_t out[6]) {
+    static bool parsed = false;
+    if (!parsed) {
+        parsed = true;
+        const char* env = getenv("HAL_MAC");
+        unsigned v[6];
+        if (env && sscanf(env, "%x:%x:%x:%x:%x:%x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 6) {
+            for (int i = 0; i < 6; i++) mac[i] = (uint8_t)v[i];
+        }
+    }
+    memcpy(out, mac, 6);
+}
+
+void hal::radioTraffic() {
+    lastTraffic = hal::clock().micros();
+}
+
+uint64_t hal::radioWake() {
+    if (powerSave == WIFI_PS_NONE || !associated) return 0;
+    uint64_t now = hal::clock().micros();
+    if (now - lastTraffic < RADIO_ACTIVE_US) return 0;
+    uint16_t listen = assocListen;
+    uint64_t beacons = powerSave == WIFI_PS_MIN_MODEM ? dtimPeriod() : (listen ? listen : 3);
+    uint64_t period = beacons * BEACON_US;
+    // Beacons du point d'accès calés sur une phase propre à la station
+    uint8_t m[6];
+    hal::macAddress(m);
+    uint64_t phase = ((uint64_t)m[4] << 8 | m[5]) * 7919 % period;
+    uint64_t next = (now + period - phase) / period * period + phase;
+    return next > now ? next - now : 0;
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type) {
+    powerSave = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t* type) {
+    if (!type) return ESP_ERR_INVALID_ARG;
+    *type = powerSave;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf) {
+    if (interface != WIFI_IF_STA || !conf) return ESP_ERR_INVALID_ARG;
+    listenInterval = conf->sta.listen_interval;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect() {
+    if (ssid.empty()) return ESP_ERR_INVALID_STATE;
+    associate();
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap) {
+    if (!ap) return ESP_ERR_INVALID_ARG;
+    if (!associated || !reachable || !link || hal::clock().micros() < linkAt) return ESP_ERR_WIFI_NOT_CONNECT;
+    *ap = {};
+    memcpy(ap->bssid, bssid, 6);
+    ap->primary = (uint8_t)apChannel();
+    ap->rssi = -55;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf) {
+    if (interface != WIFI_IF_STA || !conf) return ESP_ERR_INVALID_ARG;
+    *conf = {};
+    snprintf((char*)conf->sta.ssid, sizeof(conf->sta.ssid), "%s", ssid.c_str());
+    conf->sta.channel = (uint8_t)apChannel();
+    conf->sta.listen_interval = listenInterval;
+    return ESP_OK;
+}
+
+// --- WiFiClass -------------------------------------------------------------------
+
+wl_status_t WiFiClass::begin(const char* ssidName, const char* passphrase, int32_t channel,
+                             const uint8_t* bssidHint, bool connect) {
+    (void)passphrase;
+    ssid = ssidName ? ssidName : "";
+    hintChannel = channel;
+    hasBssidHint = bssidHint != nullptr;
+    if (bssidHint) memcpy(hintBssid, bssidHint, 6);
+    if (connect) associate();
+    else associated = false;
+    return status();
+}
+
+wl_status_t WiFiClass::status() {
+    if (!associated) return WL_DISCONNECTED;
+    if (hal::clock().micros() < readyAt) return WL_DISCONNECTED;
+    if (!reachable) return WL_NO_SSID_AVAIL;
+    return link ? WL_CONNECTED : WL_CONNECTION_LOST;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+    (void)wifioff;
+    associated = false;
+    if (eraseap) ssid.clear();
+    return true;
+}
+
+bool WiFiClass::config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2) {
+    (void)gateway; (void)subnet; (void)dns1; (void)dns2;
+    staticIp = local_ip;
+    return true;
+}
+
+IPAddress WiFiClass::localIP() {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return staticIp != IPAddress() ? staticIp : IPAddress(192, 168, 1, 50);
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask() {
+    return status() == WL_CONNECTED ? IPAddress(255, 255, 255, 0) : IPAddress();
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t dns_no) {
+    return status() == WL_CONNECTED && dns_no == 0 ? IPAddress(192, 168, 1, 1) : IPAddress();
+}
+
+String WiFiClass::macAddress() {
+    uint8_t m[6];
+    macAddress(m);
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+    return String(buf);
+}
+
+uint8_t* WiFiClass::macAddress(uint8_t* out) {
+    hal::macAddress(out);
+    return out;
+}
+
+String WiFiClass::SSID() {
+    return String(ssid);
+}
+
+int8_t WiFiClass::RSSI() {
+    return status() == WL_CONNECTED ? -55 : 0;
+}
+
+int32_t WiFiClass::channel() {
+    return status() == WL_CONNECTED ? apChannel() : 0;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    return status() == WL_CONNECTED ? bssid : nullptr;
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    if (status() != WL_CONNECTED) return 0;
+    if (result.fromString(host)) return 1;
+    result = IPAddress(10, 0, 0, 1);
+    return 1;
+}
+
+// --- WiFiClient --------------------------------------------------------------------
+
+WiFiClient::WiFiClient() {}
+
+WiFiClient::~WiFiClient() {}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    (void)timeout;
+    return connect(ip, port);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    (void)timeout;
+    return connect(host, port);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+    if (WiFi.status() != WL_CONNECTED) return 0;
+    _conn = hal::connect(host, port, secure());
+    return _conn ? 1 : 0;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    if (!_conn || !_conn->open()) return 0;
+    return _conn->send(buf, size);
+}
+
+int WiFiClient::available() {
+    return _conn ? _conn->pending() : 0;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    return _conn ? _conn->recv(buf, size) : -1;
+}
+
+int WiFiClient::peek() {
+    return _conn ? _conn->peek() : -1;
+}
+
+void WiFiClient::stop() {
+    if (_conn) _conn->close();
+    _conn.reset();
+}
+
+uint8_t WiFiClient::connected() {
+    return _conn && (_conn->open() || _conn->pending() > 0);
+}
+
+int WiFiClient::timedRead() {
+    // Connexion fermée et tampon vide : inutile d'attendre le timeout.
+    if (!connected()) return -1;
+    return Stream::timedRead();
+}
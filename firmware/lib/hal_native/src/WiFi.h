@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+typedef enum {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+// Station WiFi simulée : l'association réussit dès qu'un SSID est fourni et
+// que le lien n'a pas été coupé par hal::setLink(false), au bout du temps
+// qu'elle prendrait sur la carte (voir WiFi.cpp). Le point d'accès émet sur le
+// canal HAL_WIFI_CHANNEL (6 par défaut) ; begin() avec un canal ou un BSSID
+// qui ne sont pas les siens n'aboutit pas (WL_NO_SSID_AVAIL).
+class WiFiClass {
+public:
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    wl_status_t status();
+    bool isConnected() { return status() == WL_CONNECTED; }
+    bool disconnect(bool wifioff = false, bool eraseap = false);
+    // Adresse fixe (pas de DHCP) ; local_ip à 0.0.0.0 : retour au DHCP.
+    bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(),
+                IPAddress dns2 = IPAddress());
+    bool mode(wifi_mode_t m) { _mode = m; return true; }
+    wifi_mode_t getMode() { return _mode; }
+    bool setAutoReconnect(bool autoReconnect) { (void)autoReconnect; return true; }
+
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t dns_no = 0);
+    String macAddress();
+    uint8_t* macAddress(uint8_t* mac);
+    String SSID();
+    int8_t RSSI();
+    int32_t channel();
+    uint8_t* BSSID();
+
+    int hostByName(const char* host, IPAddress& result);
+
+private:
+    wifi_mode_t _mode = WIFI_STA;
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include "Client.h"
+
+namespace hal { class Conn; }
+
+// Client TCP simulé : la connexion est servie en mémoire par les bancs
+// enregistrés via hal::serve() (voir hal_native.h).
+class WiFiClient : public Client {
+public:
+    WiFiClient();
+    ~WiFiClient() override;
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout);
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeout);
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    void setNoDelay(bool nodelay) { (void)nodelay; }
+
+protected:
+    virtual bool secure() const { return false; }
+    int timedRead() override;
+
+    std::shared_ptr<hal::Conn> _conn;
+};
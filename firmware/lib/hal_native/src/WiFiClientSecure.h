@@ -0,0 +1,19 @@
+#pragma once
+
+#include "WiFiClient.h"
+
+// Pas de TLS sur l'hôte : le client « sécurisé » ne fait que marquer la
+// connexion comme telle pour que les compteurs de handshakes restent justes.
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() { _insecure = true; }
+    void setCACert(const char* rootCA) { _caCert = rootCA; }
+    void setHandshakeTimeout(unsigned long seconds) { (void)seconds; }
+
+protected:
+    bool secure() const override { return true; }
+
+private:
+    bool _insecure = false;
+    const char* _caCert = nullptr;
+};
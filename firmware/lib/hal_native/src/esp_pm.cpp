@@ -0,0 +1,49 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "esp_pm.h"
+
+struct esp_pm_lock {
+    esp_pm_lock_type_t type;
+    std::atomic<int> count{0};
+};
+
+esp_err_t esp_pm_configure(const void* config) {
+    if (!config) return ESP_ERR_INVALID_ARG;
+    const esp_pm_config_esp32_t* pm = (const esp_pm_config_esp32_t*)config;
+    const char* env = getenv("HAL_LIGHT_SLEEP");
+    if (pm->light_sleep_enable && env && strcmp(env, "0") == 0) return ESP_ERR_NOT_SUPPORTED;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle) {
+    (void)arg; (void)name;
+    if (!out_handle) return ESP_ERR_INVALID_ARG;
+    esp_pm_lock_handle_t lock = new esp_pm_lock();
+    lock->type = lock_type;
+    *out_handle = lock;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    handle->count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    if (handle->count.fetch_sub(1) <= 0) {
+        handle->count++;
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    if (handle->count > 0) return ESP_ERR_INVALID_STATE;
+    delete handle;
+    return ESP_OK;
+}
@@ -0,0 +1,29 @@
+// Sous-ensemble de esp_pm (ESP-IDF) pour l'hôte : la configuration et les
+// verrous sont acceptés et comptés, sans effet sur l'exécution. Avec
+// HAL_LIGHT_SLEEP=0, esp_pm_configure() refuse le light-sleep comme un core
+// compilé sans tickless idle.
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef struct {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;
+} esp_pm_config_esp32_t;
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+typedef struct esp_pm_lock* esp_pm_lock_handle_t;
+
+esp_err_t esp_pm_configure(const void* config);
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle);
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle);
@@ -0,0 +1,187 @@
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Arduino.h"
+#include "esp_timer.h"
+#include "hal_native.h"
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    uint64_t period = 0;    // 0 : un seul déclenchement
+    uint64_t deadline = 0;  // en micros() de la HAL
+    bool armed = false;
+};
+
+namespace {
+
+// Jamais détruits : la tâche esp_timer attend encore dessus à la sortie du programme
+std::mutex& timersLock = *new std::mutex();
+std::condition_variable& timersChanged = *new std::condition_variable();
+std::vector<esp_timer*>& timers = *new std::vector<esp_timer*>();
+bool dispatcherStarted = false;
+
+// Sous timersLock : prochaine échéance armée, false s'il n'y en a pas.
+bool nextDeadline(uint64_t& due) {
+    bool found = false;
+    for (esp_timer* t : timers) {
+        if (t->armed && (!found || t->deadline < due)) {
+            due = t->deadline;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Exécute les rappels échus, hors du verrou : un rappel peut arrêter ou
+// relancer son propre timer.
+void fireDue(std::unique_lock<std::mutex>& guard) {
+    for (;;) {
+        uint64_t now = hal::clock().micros();
+        esp_timer* due = nullptr;
+        for (esp_timer* t : timers) {
+            if (t->armed && t->deadline <= now && (!due || t->deadline < due->deadline)) due = t;
+        }
+        if (!due) return;
+        if (due->period) {
+            due->deadline += due->period;
+            // Rappels en retard (hôte chargé) : on ne rattrape pas, comme skip_unhandled_events
+            if (due->deadline <= now) due->deadline = now + due->period;
+        } else {
+            due->armed = false;
+        }
+        esp_timer_cb_t callback = due->callback;
+        void* arg = due->arg;
+        guard.unlock();
+        callback(arg);
+        guard.lock();
+    }
+}
+
+// Tâche esp_timer (mode avec threads).
+void dispatcher() {
+    std::unique_lock<std::mutex> guard(timersLock);
+    for (;;) {
+        uint64_t due = 0;
+        if (!nextDeadline(due)) {
+            timersChanged.wait(guard);
+            continue;
+        }
+        uint64_t now = hal::clock().micros();
+        if (due > now) {
+            timersChanged.wait_for(guard, std::chrono::microseconds(due - now));
+            continue;
+        }
+        fireDue(guard);
+    }
+}
+
+esp_err_t start(esp_timer_handle_t timer, uint64_t us, bool periodic) {
+    if (!timer || (periodic && us == 0)) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(timersLock);
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->period = periodic ? us : 0;
+    timer->deadline = hal::clock().micros() + us;
+    timer->armed = true;
+    if (hal::threadsEnabled() && !dispatcherStarted) {
+        dispatcherStarted = true;
+        std::thread(dispatcher).detach();
+    }
+    timersChanged.notify_all();
+    return ESP_OK;
+}
+
+}  // namespace
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    if (!create_args || !create_args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+    esp_timer* timer = new esp_timer();
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    std::lock_guard<std::mutex> guard(timersLock);
+    timers.push_back(timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return start(timer, timeout_us, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    return start(timer, period, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(timersLock);
+    if (!timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    timersChanged.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> guard(timersLock);
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    for (size_t i = 0; i < timers.size(); i++) {
+        if (timers[i] == timer) timers.erase(timers.begin() + i);
+    }
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> guard(timersLock);
+    return timer && timer->armed;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)hal::clock().micros();
+}
+
+void hal::timerSleep(uint64_t us) {
+    if (threadsEnabled()) {
+        clock().sleep(us);
+        return;
+    }
+    // Mode coopératif : l'attente est découpée aux échéances des timers
+    uint64_t end = clock().micros() + us;
+    std::unique_lock<std::mutex> guard(timersLock);
+    uint64_t due = 0;
+    while (nextDeadline(due) && due < end) {
+        uint64_t now = clock().micros();
+        if (due > now) {
+            guard.unlock();
+            clock().sleep(due - now);
+            guard.lock();
+        }
+        fireDue(guard);
+    }
+    guard.unlock();
+    uint64_t now = clock().micros();
+    if (end > now) clock().sleep(end - now);
+}
+
+void hal::timerPoll() {
+    if (threadsEnabled()) return;
+    std::unique_lock<std::mutex> guard(timersLock);
+    fireDue(guard);
+}
+
+bool hal::timerWait() {
+    std::unique_lock<std::mutex> guard(timersLock);
+    uint64_t due = 0;
+    if (!nextDeadline(due)) return false;
+    uint64_t now = clock().micros();
+    if (due > now) {
+        guard.unlock();
+        clock().sleep(due - now);
+        guard.lock();
+    }
+    fireDue(guard);
+    return true;
+}
@@ -0,0 +1,39 @@
+// Sous-ensemble de esp_wifi (ESP-IDF) pour l'hôte : mode d'économie de la
+// radio et intervalle d'écoute de la station, appliqués aux connexions TCP
+// réelles (voir hal::radioWake()), état de l'association avant le bail.
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+#define ESP_ERR_WIFI_NOT_CONNECT 0x300F
+
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+typedef enum { WIFI_IF_STA, WIFI_IF_AP } wifi_interface_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    uint8_t channel;
+    uint16_t listen_interval; // en beacons, en WIFI_PS_MAX_MODEM (0 : 3), pris à l'association
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t primary;
+    int8_t rssi;
+} wifi_ap_record_t;
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t* type);
+// Association avec la configuration courante (WiFi.begin(..., false) puis réglages).
+esp_err_t esp_wifi_connect();
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf);
+// Point d'accès associé, dès l'association (avant le bail DHCP) ; sinon ESP_ERR_WIFI_NOT_CONNECT.
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap);
@@ -0,0 +1,254 @@
+// Tâches, files, mutex et timers FreeRTOS sur l'hôte. En mode coopératif
+// (HAL_THREADS=0, implicite avec HAL_FAST=1) aucune tâche n'est créée :
+// xTaskCreatePinnedToCore échoue comme sur une carte à court de mémoire et le
+// firmware traite le travail dans loop(). Les attentes sur une file vide
+// deviennent des delay() ; une attente sans fin avance jusqu'aux échéances des
+// timers, seuls à pouvoir remplir la file.
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "hal_native.h"
+
+namespace {
+bool threads = true;
+}
+
+void hal::setThreads(bool enabled) {
+    threads = enabled;
+}
+
+bool hal::threadsEnabled() {
+    return threads;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth,
+                                   void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask,
+                                   BaseType_t xCoreID) {
+    (void)pcName; (void)usStackDepth; (void)uxPriority; (void)xCoreID;
+    if (!threads) return pdFAIL;
+    std::thread task(pvTaskCode, pvParameters);
+    if (pvCreatedTask) *pvCreatedTask = (TaskHandle_t)(uintptr_t)std::hash<std::thread::id>()(task.get_id());
+    task.detach();
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+    delay(xTicksToDelay * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(millis() / portTICK_PERIOD_MS);
+}
+
+void vTaskDelete(TaskHandle_t xTask) {
+    (void)xTask;
+}
+
+struct QueueDefinition {
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    std::deque<std::string> items;
+    std::mutex lock;
+    std::condition_variable changed;
+};
+
+namespace {
+
+// Attend que `ready` soit vrai, au plus `ticks`. Sans threads, personne ne
+// peut remplir la file pendant l'attente : on laisse passer le temps.
+template <typename Pred>
+bool waitFor(QueueDefinition* q, std::unique_lock<std::mutex>& guard, TickType_t ticks, Pred ready) {
+    if (ready()) return true;
+    if (ticks == 0) return false;
+    if (!threads) {
+        guard.unlock();
+        if (ticks != portMAX_DELAY) {
+            delay(ticks * portTICK_PERIOD_MS);
+        } else {
+            // Sans timer armé, rien ne viendra : on rend la main
+            while (hal::timerWait()) {
+                guard.lock();
+                if (ready()) return true;
+                guard.unlock();
+            }
+        }
+        guard.lock();
+        return ready();
+    }
+    if (ticks == portMAX_DELAY) { q->changed.wait(guard, ready); return true; }
+    return q->changed.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), ready);
+}
+
+BaseType_t send(QueueHandle_t q, const void* item, TickType_t ticks, bool front) {
+    std::unique_lock<std::mutex> guard(q->lock);
+    if (!waitFor(q, guard, ticks, [q] { return q->items.size() < q->length; })) return errQUEUE_FULL;
+    std::string data((const char*)item, q->itemSize);
+    if (front) q->items.push_front(data);
+    else q->items.push_back(data);
+    q->changed.notify_all();
+    return pdPASS;
+}
+
+}  // namespace
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    QueueDefinition* q = new QueueDefinition();
+    q->length = uxQueueLength;
+    q->itemSize = uxItemSize;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+    delete xQueue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait) {
+    return send(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait) {
+    return send(xQueue, pvItemToQueue, xTicksToWait, true);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void* pvItemToQueue) {
+    std::lock_guard<std::mutex> guard(xQueue->lock);
+    xQueue->items.clear();
+    xQueue->items.emplace_back((const char*)pvItemToQueue, xQueue->itemSize);
+    xQueue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait) {
+    std::unique_lock<std::mutex> guard(xQueue->lock);
+    if (!waitFor(xQueue, guard, xTicksToWait, [xQueue] { return !xQueue->items.empty(); })) return pdFALSE;
+    memcpy(pvBuffer, xQueue->items.front().data(), xQueue->itemSize);
+    xQueue->items.pop_front();
+    xQueue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> guard(xQueue->lock);
+    xQueue->items.clear();
+    xQueue->changed.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+    std::lock_guard<std::mutex> guard(xQueue->lock);
+    return (UBaseType_t)xQueue->items.size();
+}
+
+// Mutex FreeRTOS : sans threads, personne d'autre ne peut le tenir.
+struct SemaphoreDefinition {
+    std::timed_mutex lock;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new SemaphoreDefinition();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore) {
+    delete xSemaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xTicksToWait) {
+    if (xTicksToWait == portMAX_DELAY) { xSemaphore->lock.lock(); return pdTRUE; }
+    return xSemaphore->lock.try_lock_for(std::chrono::milliseconds(xTicksToWait * portTICK_PERIOD_MS)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+    xSemaphore->lock.unlock();
+    return pdTRUE;
+}
+
+// Timers logiciels sur esp_timer. Comme sur la carte, changer la période d'un
+// timer arrêté le démarre, et le démarrer alors qu'il tourne le réarme.
+struct tmrTimerControl {
+    esp_timer_handle_t timer;
+    TickType_t period;
+    bool autoReload;
+    void* id;
+    TimerCallbackFunction_t callback;
+};
+
+namespace {
+
+void timerFired(void* arg) {
+    TimerHandle_t t = (TimerHandle_t)arg;
+    t->callback(t);
+}
+
+BaseType_t arm(TimerHandle_t t) {
+    esp_timer_stop(t->timer);
+    uint64_t us = (uint64_t)t->period * portTICK_PERIOD_MS * 1000;
+    esp_err_t err = t->autoReload ? esp_timer_start_periodic(t->timer, us) : esp_timer_start_once(t->timer, us);
+    return err == ESP_OK ? pdPASS : pdFAIL;
+}
+
+}  // namespace
+
+TimerHandle_t xTimerCreate(const char* pcTimerName, TickType_t xTimerPeriodInTicks, UBaseType_t uxAutoReload,
+                           void* pvTimerID, TimerCallbackFunction_t pxCallbackFunction) {
+    if (xTimerPeriodInTicks == 0 || !pxCallbackFunction) return nullptr;
+    TimerHandle_t t = new tmrTimerControl{ nullptr, xTimerPeriodInTicks, uxAutoReload != 0, pvTimerID, pxCallbackFunction };
+    esp_timer_create_args_t args = { timerFired, t, ESP_TIMER_TASK, pcTimerName, true };
+    if (esp_timer_create(&args, &t->timer) != ESP_OK) {
+        delete t;
+        return nullptr;
+    }
+    return t;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+    return arm(xTimer);
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+    esp_timer_stop(xTimer->timer);
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    return xTimerStart(xTimer, xTicksToWait);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+    if (xNewPeriod == 0) return pdFAIL;
+    xTimer->period = xNewPeriod;
+    return arm(xTimer);
+}
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait) {
+    (void)xTicksToWait;
+    esp_timer_stop(xTimer->timer);
+    esp_timer_delete(xTimer->timer);
+    delete xTimer;
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer) {
+    return esp_timer_is_active(xTimer->timer) ? pdTRUE : pdFALSE;
+}
+
+TickType_t xTimerGetPeriod(TimerHandle_t xTimer) {
+    return xTimer->period;
+}
+
+void* pvTimerGetTimerID(TimerHandle_t xTimer) {
+    return xTimer->id;
+}
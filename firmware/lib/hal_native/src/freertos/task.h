@@ -0,0 +1,10 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth,
+                                   void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask,
+                                   BaseType_t xCoreID);
+void vTaskDelay(TickType_t xTicksToDelay);
+TickType_t xTaskGetTickCount();
+void vTaskDelete(TaskHandle_t xTask);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Timers logiciels : rappels exécutés par le dispatcher de esp_timer (tâche
+// dédiée, ou pendant les attentes du firmware en mode coopératif).
+typedef struct tmrTimerControl* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+
+TimerHandle_t xTimerCreate(const char* pcTimerName, TickType_t xTimerPeriodInTicks, UBaseType_t uxAutoReload,
+                           void* pvTimerID, TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait);
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer);
+TickType_t xTimerGetPeriod(TimerHandle_t xTimer);
+void* pvTimerGetTimerID(TimerHandle_t xTimer);
@@ -0,0 +1,69 @@
+// Point d'entrée du programme natif : joue le rôle du cœur Arduino
+// (setup() puis loop() en boucle). Les outils qui fournissent leur propre
+// main() compilent avec -DHAL_NATIVE_NO_MAIN.
+#ifndef HAL_NATIVE_NO_MAIN
+
+#include <chrono>
+
+#include "Arduino.h"
+#include "hal_native.h"
+
+void setup();
+void loop();
+
+// Variables d'environnement :
+//   HAL_LOOPS=n         nombre d'itérations de loop() (0 = infini)
+//   HAL_FAST=1          delay() avance l'horloge au lieu de dormir
+//   HAL_QUIET=1         coupe la sortie Serial
+//   HAL_TEMP, HAL_AQI   météo servie par le banc Open-Meteo
+//   HAL_COMMAND         ordre renvoyé par le banc backend (AUTO, OPEN, CLOSE)
+//   HAL_NVS             contenu initial de la NVS ("config.ssid=...,config.lat=...")
+//   HAL_BLE_CONFIG      écriture BLE de configuration rejouée après setup()
+//   HAL_BLE_RULES       écriture BLE des règles du mode AUTO, après setup()
+//   HAL_WIFI_CHANNEL    canal du point d'accès simulé (6 par défaut)
+int main() {
+    hal::begin();
+    const char* env = getenv("HAL_LOOPS");
+    unsigned long loops = env ? strtoul(env, nullptr, 10) : 0;
+
+    auto start = std::chrono::steady_clock::now();
+    bool booted = false;
+    bool configReplayed = false;
+    bool rulesReplayed = false;
+    unsigned long i = 0;
+    while (loops == 0 || i < loops) {
+        try {
+            if (!booted) {
+                setup();
+                booted = true;
+                const char* config = getenv("HAL_BLE_CONFIG");
+                if (config && !configReplayed) {
+                    configReplayed = true;
+                    hal::bleWrite("beb5483e-36e1-4688-b7f5-ea07361b26a8", config);
+                }
+                const char* rules = getenv("HAL_BLE_RULES");
+                if (rules && !rulesReplayed) {
+                    rulesReplayed = true;
+                    hal::bleWrite("beb5483e-36e1-4688-b7f5-ea07361b26a9", rules);
+                }
+            }
+            loop();
+            i++;
+        } catch (const hal::Restart&) {
+            fprintf(stderr, "[hal] ESP.restart()\n");
+            booted = false;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const hal::Stats& s = hal::stats();
+    fprintf(stderr,
+            "[hal] %lu loops en %.3f s (%.0f loops/s), %llu requêtes, %llu connexions (%llu TLS), "
+            "%llu écritures servo, %llu octets flash\n",
+            i, seconds, seconds > 0 ? i / seconds : 0.0, (unsigned long long)s.requests,
+            (unsigned long long)s.connects, (unsigned long long)s.handshakes, (unsigned long long)s.servoWrites,
+            (unsigned long long)s.flashBytes);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,192 @@
+// Pilotage de la HAL simulée depuis l'hôte (programme natif, outils).
+// Le firmware n'inclut jamais ce fichier : il ne voit que les en-têtes Arduino.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace hal {
+
+// Levée par ESP.restart() ; le programme natif relance setup().
+struct Restart {};
+
+// --- Réseau simulé ---------------------------------------------------------
+
+struct HttpRequest {
+    std::string method;
+    std::string path;     // chemin + query string
+    std::string host;
+    uint16_t port = 0;
+    std::map<std::string, std::string> headers;  // clés en minuscules
+    std::string body;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string contentType = "application/json";
+    std::string body;
+    std::map<std::string, std::string> headers;
+    bool chunked = false;  // corps envoyé en Transfer-Encoding: chunked
+    bool close = false;    // le serveur ferme après la réponse
+    bool drop = false;     // le serveur coupe sans répondre
+};
+
+typedef std::function<void(const HttpRequest&, HttpResponse&)> HttpHandler;
+
+// Enregistre un serveur simulé ; host "*" répond pour tout hôte sur ce port.
+void serve(const std::string& host, uint16_t port, HttpHandler handler);
+
+// Connexion établie par WiFiClient (interne à la HAL).
+class Conn {
+public:
+    virtual ~Conn() {}
+    virtual size_t send(const uint8_t* buf, size_t size) = 0;
+    virtual int recv(uint8_t* buf, size_t size) = 0;  // -1 si rien à lire
+    virtual int peek() = 0;
+    virtual int pending() = 0;
+    virtual bool open() = 0;
+    virtual void close() = 0;
+};
+
+std::shared_ptr<Conn> connect(const std::string& host, uint16_t port, bool secure);
+
+// Envoie host:port vers un vrai serveur TCP ("127.0.0.1:4001") au lieu d'un
+// banc en mémoire ; host "*" redirige tout hôte sur ce port.
+void redirect(const std::string& host, uint16_t port, const std::string& target);
+// "hote:port=cible:port,..." (format de HAL_REDIRECT).
+void redirectLoad(const std::string& spec);
+bool redirected(const std::string& host, uint16_t port);
+std::shared_ptr<Conn> socketConnect(const std::string& host, uint16_t port);  // interne
+
+// Les bancs en mémoire ferment une connexion gardée restée sans requête plus de
+// `ms` (5000 par défaut, comme Node ; HAL_KEEPALIVE_MS, 0 = jamais) et
+// l'annoncent dans « Keep-Alive: timeout= ».
+void setKeepAlive(uint32_t ms);
+
+// Coupe / rétablit le lien WiFi simulé (les sockets ouverts sont fermés).
+void setLink(bool up);
+bool linkUp();
+
+// Adresse MAC simulée (HAL_MAC="aa:bb:cc:dd:ee:ff"), base de l'identité du device.
+void macAddress(uint8_t mac[6]);
+
+// Radio en modem-sleep (esp_wifi_set_ps()) sur les connexions TCP réelles :
+// une trame qui arrive pendant que la station dort attend son prochain réveil
+// (interne). radioTraffic() note un échange, radioWake() donne l'attente en µs.
+void radioTraffic();
+uint64_t radioWake();
+
+// --- Bancs par défaut (Open-Meteo + backend /api/window/log) -----------------
+
+namespace standin {
+void install();
+void setWeather(float temp, int aqi);
+void setCommand(const char* command);
+// Corps brut du dernier POST /api/window/log (JSON ou MessagePack).
+std::string lastLog();
+// Backend qui parle MessagePack (par défaut, HAL_MSGPACK=0 pour un backend
+// JSON seul, qui refuse les corps binaires avec 415).
+void setMsgPack(bool enabled);
+// Backend injoignable : les connexions sont coupées sans réponse.
+void setBackendDown(bool down);
+// Échantillons reçus par POST /api/window/log/batch.
+uint64_t batchedSamples();
+}
+
+// --- Périphériques -----------------------------------------------------------
+
+// Écrit sur une caractéristique BLE et déclenche son onWrite().
+bool bleWrite(const char* uuid, const std::string& value);
+
+void nvsSet(const std::string& ns, const std::string& key, const std::string& value);
+// "ns.cle=valeur,ns.cle=valeur" (format de HAL_NVS).
+void nvsLoad(const std::string& spec);
+
+// Efface le LittleFS simulé (les fichiers survivent sinon à ESP.restart()).
+void fsFormat();
+// Mémoire hôte occupée par ces fichiers (exclue du tas simulé).
+size_t fsResidentBytes();
+
+// --- Horloge et tâches -------------------------------------------------------
+
+// Source de temps de millis(), micros(), delay() et time().
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual uint64_t micros() = 0;   // depuis le boot
+    virtual uint64_t epochUs() = 0;  // heure murale (time(), horodatage NTP)
+    virtual void sleep(uint64_t us) = 0;
+    // Attente active (yield() dans une boucle de timeout)
+    virtual void spin() = 0;
+};
+
+// Horloge simulée : le temps n'avance que lorsque le firmware attend (delay(),
+// file FreeRTOS vide, timeout de lecture) ou par advance(). Une semaine de
+// poll se rejoue ainsi en quelques secondes, de façon reproductible.
+// À utiliser sans threads (setThreads(false)).
+class SimClock : public Clock {
+public:
+    explicit SimClock(uint64_t epochUs = 0) : _epochUs(epochUs) {}
+    uint64_t micros() override { return _us; }
+    uint64_t epochUs() override { return _epochUs + _us; }
+    void sleep(uint64_t us) override { _us += us; }
+    void spin() override { _us += 1000; }
+    void advance(uint64_t us) { _us += us; }
+
+private:
+    uint64_t _epochUs;
+    std::atomic<uint64_t> _us{0};
+};
+
+// nullptr : horloge réelle de l'hôte. L'horloge installée doit survivre au programme.
+void setClock(Clock* clock);
+Clock& clock();
+
+// Mode rapide (HAL_FAST) : une SimClock partant de l'heure réelle.
+void setFastClock(bool fast);
+
+// Attente de delay() : sans threads, exécute au passage les timers esp_timer
+// échus (interne).
+void timerSleep(uint64_t us);
+void timerPoll();
+// Sans threads : avance jusqu'à la prochaine échéance de timer et exécute les
+// rappels échus ; false s'il n'y a aucun timer armé (interne).
+bool timerWait();
+
+// Sans threads, xTaskCreatePinnedToCore() échoue et le firmware reste
+// mono-tâche (déterministe). Désactivés par défaut en mode rapide.
+void setThreads(bool enabled);
+bool threadsEnabled();
+
+// --- Compteurs ----------------------------------------------------------------
+
+// Atomiques : incrémentés depuis la tâche réseau, lus depuis l'hôte.
+struct Stats {
+    std::atomic<uint64_t> connects{0};     // connexions TCP ouvertes
+    std::atomic<uint64_t> handshakes{0};   // dont connexions « TLS »
+    std::atomic<uint64_t> requests{0};     // requêtes HTTP servies par les bancs en mémoire
+    std::atomic<uint64_t> httpRequests{0};  // requêtes émises par HTTPClient (bancs et sockets réels)
+    std::atomic<uint64_t> httpFailures{0};  // dont échecs réseau (code < 0)
+    std::atomic<uint64_t> httpErrors{0};    // dont réponses >= 400
+    std::atomic<uint64_t> servoWrites{0};  // consignes envoyées au servo
+    std::atomic<uint64_t> flashBytes{0};   // octets écrits sur le LittleFS
+    std::atomic<uint64_t> idleClosed{0};   // connexions gardées fermées par un banc après son keep-alive
+    std::atomic<int> servoAngle{-1};
+};
+
+Stats& stats();
+
+// Remet à zéro la mesure du tas simulé (ESP.getFreeHeap()).
+void heapReset();
+
+void setQuiet(bool quiet);
+bool quiet();
+
+// Lit la configuration HAL_* de l'environnement et installe les bancs.
+void begin();
+
+}  // namespace hal
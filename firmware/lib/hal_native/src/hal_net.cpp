@@ -0,0 +1,424 @@
+// Réseau simulé : chaque connexion WiFiClient est servie en mémoire par un
+// gestionnaire HTTP enregistré avec hal::serve(). Le flux d'octets est réel
+// (en-têtes, Content-Length, chunked, keep-alive) pour que HTTPClient et
+// ArduinoJson travaillent exactement comme sur la carte.
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "Arduino.h"
+#include "hal_native.h"
+
+namespace {
+
+struct Route {
+    std::string host;
+    uint16_t port;
+    hal::HttpHandler handler;
+};
+
+std::vector<Route> routes;
+std::mutex routesLock;
+bool quietSerial = false;
+hal::Stats counters;
+std::atomic<uint32_t> keepAliveMs{5000};
+
+bool findRoute(const std::string& host, uint16_t port, hal::HttpHandler& out) {
+    std::lock_guard<std::mutex> guard(routesLock);
+    const hal::HttpHandler* wildcard = nullptr;
+    for (const Route& r : routes) {
+        if (r.port != port) continue;
+        if (r.host == host) { out = r.handler; return true; }
+        if (r.host == "*") wildcard = &r.handler;
+    }
+    if (wildcard) out = *wildcard;
+    return wildcard != nullptr;
+}
+
+const char* reason(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 415: return "Unsupported Media Type";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Status";
+    }
+}
+
+std::string lower(std::string s) {
+    for (char& c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+class LoopConn : public hal::Conn {
+public:
+    LoopConn(const std::string& host, uint16_t port, const hal::HttpHandler& handler)
+        : _host(host), _port(port), _handler(handler) {}
+
+    size_t send(const uint8_t* buf, size_t size) override {
+        if (!open()) return 0;
+        _in.append((const char*)buf, size);
+        while (_open && serveOne()) {}
+        _lastActive = millis();
+        return size;
+    }
+
+    int recv(uint8_t* buf, size_t size) override {
+        if (_out.empty()) return -1;
+        size_t n = std::min(size, _out.size());
+        for (size_t i = 0; i < n; i++) { buf[i] = (uint8_t)_out.front(); _out.pop_front(); }
+        return (int)n;
+    }
+
+    int peek() override { return _out.empty() ? -1 : (uint8_t)_out.front(); }
+    int pending() override { return (int)_out.size(); }
+    bool open() override {
+        // Connexion gardée sans requête au-delà du keep-alive : le serveur l'a fermée
+        uint32_t idle = keepAliveMs;
+        if (_open && idle && _out.empty() && _in.empty() && millis() - _lastActive > idle) {
+            _open = false;
+            counters.idleClosed++;
+        }
+        return _open && hal::linkUp();
+    }
+    void close() override { _open = false; _in.clear(); }
+
+private:
+    // Traite une requête complète du tampon d'entrée, s'il y en a une.
+    bool serveOne() {
+        size_t headerEnd = _in.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) return false;
+
+        hal::HttpRequest req;
+        req.host = _host;
+        req.port = _port;
+        size_t lineEnd = _in.find("\r\n");
+        std::string requestLine = _in.substr(0, lineEnd);
+        size_t sp1 = requestLine.find(' ');
+        size_t sp2 = requestLine.find(' ', sp1 + 1);
+        req.method = requestLine.substr(0, sp1);
+        req.path = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+        bool http10 = requestLine.compare(sp2 + 1, std::string::npos, "HTTP/1.0") == 0;
+
+        size_t pos = lineEnd + 2;
+        while (pos < headerEnd) {
+            size_t eol = _in.find("\r\n", pos);
+            std::string line = _in.substr(pos, eol - pos);
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                size_t v = line.find_first_not_of(' ', colon + 1);
+                req.headers[lower(line.substr(0, colon))] = v == std::string::npos ? "" : line.substr(v);
+            }
+            pos = eol + 2;
+        }
+
+        size_t length = 0;
+        auto cl = req.headers.find("content-length");
+        if (cl != req.headers.end()) length = strtoul(cl->second.c_str(), nullptr, 10);
+        if (_in.size() < headerEnd + 4 + length) return false;
+        req.body = _in.substr(headerEnd + 4, length);
+        _in.erase(0, headerEnd + 4 + length);
+
+        hal::HttpResponse res;
+        _handler(req, res);
+        counters.requests++;
+        if (res.drop) { close(); return false; }
+
+        auto conn = req.headers.find("connection");
+        bool keepAlive = !http10 && !res.close && (conn == req.headers.end() || lower(conn->second) != "close");
+
+        std::string head = std::string(http10 ? "HTTP/1.0 " : "HTTP/1.1 ") + std::to_string(res.status) + " " +
+                           reason(res.status) + "\r\n";
+        if (!res.contentType.empty()) head += "Content-Type: " + res.contentType + "\r\n";
+        for (const auto& h : res.headers) head += h.first + ": " + h.second + "\r\n";
+        if (res.chunked && !http10) head += "Transfer-Encoding: chunked\r\n";
+        else head += "Content-Length: " + std::to_string(res.body.size()) + "\r\n";
+        if (keepAlive && keepAliveMs) head += "Keep-Alive: timeout=" + std::to_string(keepAliveMs / 1000) + "\r\n";
+        head += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        _out.insert(_out.end(), head.begin(), head.end());
+
+        if (res.chunked && !http10) {
+            // Découpe arbitraire en morceaux de 64 octets, comme un vrai serveur.
+            for (size_t off = 0; off < res.body.size(); off += 64) {
+                size_t n = std::min<size_t>(64, res.body.size() - off);
+                char size[16];
+                snprintf(size, sizeof(size), "%zx\r\n", n);
+                _out.insert(_out.end(), size, size + strlen(size));
+                _out.insert(_out.end(), res.body.begin() + off, res.body.begin() + off + n);
+                _out.push_back('\r'); _out.push_back('\n');
+            }
+            const char* last = "0\r\n\r\n";
+            _out.insert(_out.end(), last, last + 5);
+        } else {
+            _out.insert(_out.end(), res.body.begin(), res.body.end());
+        }
+
+        if (!keepAlive) _open = false;
+        return true;
+    }
+
+    std::string _host;
+    uint16_t _port;
+    hal::HttpHandler _handler;
+    std::string _in;
+    std::deque<char> _out;
+    bool _open = true;
+    unsigned long _lastActive = millis();
+};
+
+}  // namespace
+
+void hal::serve(const std::string& host, uint16_t port, HttpHandler handler) {
+    std::lock_guard<std::mutex> guard(routesLock);
+    for (Route& r : routes) {
+        if (r.host == host && r.port == port) { r.handler = handler; return; }
+    }
+    routes.push_back({host, port, handler});
+}
+
+std::shared_ptr<hal::Conn> hal::connect(const std::string& host, uint16_t port, bool secure) {
+    if (!linkUp()) return nullptr;
+    if (redirected(host, port)) {
+        std::shared_ptr<Conn> conn = socketConnect(host, port);
+        if (conn) counters.connects++;
+        return conn;
+    }
+    HttpHandler handler;
+    if (!findRoute(host, port, handler)) return nullptr;
+    counters.connects++;
+    if (secure) counters.handshakes++;
+    return std::make_shared<LoopConn>(host, port, handler);
+}
+
+hal::Stats& hal::stats() {
+    return counters;
+}
+
+void hal::setKeepAlive(uint32_t ms) {
+    keepAliveMs = ms;
+}
+
+void hal::setQuiet(bool quiet) {
+    quietSerial = quiet;
+}
+
+bool hal::quiet() {
+    return quietSerial;
+}
+
+// --- Bancs par défaut ----------------------------------------------------------
+
+namespace {
+// Jamais détruits : un long-poll de la tâche push peut attendre dessus à la sortie
+std::mutex& standinLock = *new std::mutex();
+std::condition_variable& standinChanged = *new std::condition_variable();  // réveille les long-polls de /api/window/command
+float standinTemp = 22.5f;
+int standinAQI = 25;
+std::string standinCommand = "AUTO";
+uint64_t standinVersion = 1;
+std::string standinLastLog;
+bool standinBackendDown = false;
+bool standinMsgPack = true;
+uint64_t standinBatched = 0;
+
+// Champ d'une réponse du backend : booléen, entier non signé ou chaîne.
+struct Field {
+    std::string key;
+    enum { BOOL, UINT, STR } type;
+    uint64_t n;
+    std::string s;
+};
+
+Field flag(const std::string& key, bool v) { return {key, Field::BOOL, v, ""}; }
+Field number(const std::string& key, uint64_t v) { return {key, Field::UINT, v, ""}; }
+Field text(const std::string& key, const std::string& v) { return {key, Field::STR, 0, v}; }
+
+// command, version (sous standinLock)
+std::vector<Field> commandFields() {
+    return { text("command", standinCommand), number("version", standinVersion) };
+}
+
+void packUint(std::string& out, uint64_t v) {
+    if (v < 0x80) { out += (char)v; return; }
+    int bytes = v <= 0xff ? 1 : v <= 0xffff ? 2 : v <= 0xffffffffULL ? 4 : 8;
+    out += (char)(bytes == 1 ? 0xcc : bytes == 2 ? 0xcd : bytes == 4 ? 0xce : 0xcf);
+    for (int i = bytes - 1; i >= 0; i--) out += (char)(v >> (8 * i));
+}
+
+// Chaînes de moins de 32 octets : fixstr (assez pour ces réponses)
+void packStr(std::string& out, const std::string& v) {
+    out += (char)(0xa0 | v.size());
+    out += v;
+}
+
+// Objet plat en JSON, ou en MessagePack si la requête l'accepte, comme reply() de server.js.
+void reply(const hal::HttpRequest& req, hal::HttpResponse& res, const std::vector<Field>& fields) {
+    auto accept = req.headers.find("accept");
+    if (standinMsgPack && accept != req.headers.end() && accept->second.find("application/msgpack") != std::string::npos) {
+        res.contentType = "application/msgpack";
+        res.body = (char)(0x80 | fields.size());
+        for (const Field& f : fields) {
+            packStr(res.body, f.key);
+            if (f.type == Field::BOOL) res.body += (char)(f.n ? 0xc3 : 0xc2);
+            else if (f.type == Field::UINT) packUint(res.body, f.n);
+            else packStr(res.body, f.s);
+        }
+        return;
+    }
+    res.body = "{";
+    for (const Field& f : fields) {
+        if (res.body.size() > 1) res.body += ",";
+        res.body += "\"" + f.key + "\":";
+        if (f.type == Field::BOOL) res.body += f.n ? "true" : "false";
+        else if (f.type == Field::UINT) res.body += std::to_string(f.n);
+        else res.body += "\"" + f.s + "\"";
+    }
+    res.body += "}";
+}
+
+std::string queryParam(const std::string& path, const std::string& key) {
+    size_t q = path.find('?');
+    while (q != std::string::npos) {
+        size_t end = path.find('&', q + 1);
+        std::string item = path.substr(q + 1, end == std::string::npos ? std::string::npos : end - q - 1);
+        if (item.compare(0, key.size() + 1, key + "=") == 0) return item.substr(key.size() + 1);
+        q = end;
+    }
+    return "";
+}
+}
+
+void hal::standin::setWeather(float temp, int aqi) {
+    std::lock_guard<std::mutex> guard(standinLock);
+    standinTemp = temp;
+    standinAQI = aqi;
+}
+
+void hal::standin::setCommand(const char* command) {
+    std::lock_guard<std::mutex> guard(standinLock);
+    if (standinCommand == command) return;
+    standinCommand = command;
+    standinVersion++;
+    standinChanged.notify_all();
+}
+
+std::string hal::standin::lastLog() {
+    std::lock_guard<std::mutex> guard(standinLock);
+    return standinLastLog;
+}
+
+void hal::standin::setBackendDown(bool down) {
+    std::lock_guard<std::mutex> guard(standinLock);
+    standinBackendDown = down;
+    standinChanged.notify_all();
+}
+
+void hal::standin::setMsgPack(bool enabled) {
+    std::lock_guard<std::mutex> guard(standinLock);
+    standinMsgPack = enabled;
+}
+
+uint64_t hal::standin::batchedSamples() {
+    std::lock_guard<std::mutex> guard(standinLock);
+    return standinBatched;
+}
+
+void hal::standin::install() {
+    // Réponse au format Open-Meteo, avec les métadonnées que renvoie le vrai service.
+    serve("api.open-meteo.com", 443, [](const HttpRequest& req, HttpResponse& res) {
+        if (req.path.rfind("/v1/forecast", 0) != 0) { res.status = 404; res.body = "{}"; return; }
+        std::lock_guard<std::mutex> guard(standinLock);
+        // Valeur du dernier quart d'heure échu, comme le service réel
+        time_t now = time(nullptr);
+        time_t slot = now - now % 900;
+        struct tm utc;
+        char iso[24];
+        strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M", gmtime_r(&slot, &utc));
+        char body[512];
+        snprintf(body, sizeof(body),
+                 "{\"latitude\":45.18,\"longitude\":5.72,\"generationtime_ms\":0.05,\"utc_offset_seconds\":0,"
+                 "\"timezone\":\"GMT\",\"timezone_abbreviation\":\"GMT\",\"elevation\":214.0,"
+                 "\"current_units\":{\"time\":\"iso8601\",\"interval\":\"seconds\",\"temperature_2m\":\"°C\","
+                 "\"european_aqi\":\"EAQI\"},"
+                 "\"current\":{\"time\":\"%s\",\"interval\":900,\"temperature_2m\":%.1f,"
+                 "\"european_aqi\":%d",
+                 iso, standinTemp, standinAQI);
+        res.body = body;
+        // Champs facultatifs, servis seulement s'ils sont demandés (comme l'API réelle)
+        if (req.path.find("wind_speed_10m") != std::string::npos) res.body += ",\"wind_speed_10m\":12.4";
+        if (req.path.find("precipitation") != std::string::npos) res.body += ",\"precipitation\":0.0";
+        if (req.path.find("relative_humidity_2m") != std::string::npos) res.body += ",\"relative_humidity_2m\":58";
+        res.body += "}}";
+        res.chunked = true;  // comme le service réel derrière son CDN
+    });
+
+    // Backend : même contrat que /api/window/log(/batch) et /api/window/command de backend/src/server.js.
+    serve("*", 3001, [](const HttpRequest& req, HttpResponse& res) {
+        std::unique_lock<std::mutex> guard(standinLock);
+        if (standinBackendDown) { res.drop = true; return; }
+        auto type = req.headers.find("content-type");
+        bool packed = type != req.headers.end() && type->second.rfind("application/msgpack", 0) == 0;
+        if (packed && !standinMsgPack) { res.status = 415; res.body = "{}"; return; }
+        if (req.method == "POST" && req.path == "/api/window/log/batch") {
+            // Pas de parseur ici : un échantillon = une clé "isOpen" (fixstr de 6 octets en MessagePack).
+            std::string key = packed ? std::string("\xa6isOpen") : std::string("\"isOpen\"");
+            uint64_t n = 0;
+            for (size_t pos = req.body.find(key); pos != std::string::npos; pos = req.body.find(key, pos + 1)) n++;
+            standinBatched += n;
+            std::vector<Field> fields = { flag("success", true), number("stored", n) };
+            for (const Field& f : commandFields()) fields.push_back(f);
+            reply(req, res, fields);
+            return;
+        }
+        if (req.method == "GET" && req.path.rfind("/api/window/command", 0) == 0) {
+            // Long-poll : la réponse attend un changement d'ordre, au plus `wait` secondes.
+            std::string since = queryParam(req.path, "since");
+            long wait = atol(queryParam(req.path, "wait").c_str());
+            if (!since.empty() && wait > 0) {
+                uint64_t known = strtoull(since.c_str(), nullptr, 10);
+                standinChanged.wait_for(guard, std::chrono::seconds(std::min(wait, 55L)),
+                                        [known] { return standinVersion != known || standinBackendDown; });
+                if (standinBackendDown) { res.drop = true; return; }
+            }
+            reply(req, res, commandFields());
+            return;
+        }
+        if (req.method != "POST" || req.path != "/api/window/log") { res.status = 404; res.body = "{}"; return; }
+        standinLastLog = req.body;
+        std::vector<Field> fields = { flag("success", true) };
+        for (const Field& f : commandFields()) fields.push_back(f);
+        reply(req, res, fields);
+    });
+}
+
+// --- Configuration --------------------------------------------------------------
+
+void hal::begin() {
+    heapReset();
+    const char* env;
+    if ((env = getenv("HAL_QUIET")) && atoi(env)) setQuiet(true);
+    if ((env = getenv("HAL_FAST")) && atoi(env)) { setFastClock(true); setThreads(false); }
+    if ((env = getenv("HAL_THREADS"))) setThreads(atoi(env) != 0);
+    if ((env = getenv("HAL_REDIRECT"))) redirectLoad(env);
+    if ((env = getenv("HAL_KEEPALIVE_MS"))) setKeepAlive(strtoul(env, nullptr, 10));
+
+    standin::install();
+    float temp = 22.5f;
+    int aqi = 25;
+    if ((env = getenv("HAL_TEMP"))) temp = strtof(env, nullptr);
+    if ((env = getenv("HAL_AQI"))) aqi = atoi(env);
+    standin::setWeather(temp, aqi);
+    if ((env = getenv("HAL_COMMAND"))) standin::setCommand(env);
+    if ((env = getenv("HAL_MSGPACK"))) standin::setMsgPack(atoi(env) != 0);
+
+    // Sans configuration NVS, on se comporte comme un appareil déjà provisionné.
+    env = getenv("HAL_NVS");
+    nvsLoad(env ? env : "config.ssid=native-ap");
+}
@@ -0,0 +1,197 @@
+// Connexions TCP réelles pour les routes redirigées (hal::redirect(),
+// HAL_REDIRECT) : le firmware natif parle alors à un vrai serveur local,
+// par exemple le backend Node ou le banc de charge de tools/fleet.
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Arduino.h"
+#include "hal_native.h"
+
+namespace {
+
+struct Redirect {
+    std::string host;  // "*" : tout hôte
+    uint16_t port;
+    std::string targetHost;
+    uint16_t targetPort;
+};
+
+std::vector<Redirect> redirects;
+std::mutex redirectsLock;
+
+// Attente d'un octet quand le tampon noyau est vide : sans elle, les boucles
+// d'attente active de HTTPClient (available() puis yield()) occuperaient un
+// cœur par connexion, ce qui compte avec des milliers d'instances.
+const int IDLE_WAIT_MS = 1;
+
+class SocketConn : public hal::Conn {
+public:
+    explicit SocketConn(int fd) : _fd(fd) {}
+    ~SocketConn() override { close(); }
+
+    size_t send(const uint8_t* buf, size_t size) override {
+        size_t sent = 0;
+        while (open() && sent < size) {
+            ssize_t n = ::send(_fd, buf + sent, size - sent, MSG_NOSIGNAL);
+            if (n > 0) { sent += n; hal::radioTraffic(); continue; }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd p = { _fd, POLLOUT, 0 };
+                poll(&p, 1, 1000);
+                continue;
+            }
+            _eof = true;
+        }
+        return sent;
+    }
+
+    int recv(uint8_t* buf, size_t size) override {
+        if (_fd < 0) return -1;
+        ssize_t n = ::recv(_fd, buf, size, MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && wait()) n = ::recv(_fd, buf, size, MSG_DONTWAIT);
+        if (n == 0) _eof = true;
+        return n > 0 ? (int)n : -1;
+    }
+
+    int peek() override {
+        if (_fd < 0) return -1;
+        uint8_t c;
+        ssize_t n = ::recv(_fd, &c, 1, MSG_DONTWAIT | MSG_PEEK);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && wait()) n = ::recv(_fd, &c, 1, MSG_DONTWAIT | MSG_PEEK);
+        if (n == 0) _eof = true;
+        return n == 1 ? c : -1;
+    }
+
+    int pending() override {
+        if (_fd < 0) return 0;
+        int n = 0;
+        ioctl(_fd, FIONREAD, &n);
+        if (n == 0 && wait()) ioctl(_fd, FIONREAD, &n);
+        return n;
+    }
+
+    bool open() override {
+        if (_fd < 0 || _eof || !hal::linkUp()) return false;
+        pollfd p = { _fd, POLLRDHUP, 0 };
+        if (poll(&p, 1, 0) > 0 && (p.revents & (POLLRDHUP | POLLHUP | POLLERR))) _eof = true;
+        return !_eof;
+    }
+
+    void close() override {
+        if (_fd >= 0) ::close(_fd);
+        _fd = -1;
+    }
+
+private:
+    // Vrai si des octets (ou la fin du flux) sont arrivés pendant l'attente.
+    // Une station en modem-sleep ne les voit qu'à son prochain réveil.
+    bool wait() {
+        if (_eof) return false;
+        pollfd p = { _fd, POLLIN, 0 };
+        if (poll(&p, 1, IDLE_WAIT_MS) <= 0) return false;
+        uint64_t doze = hal::radioWake();
+        if (doze) hal::clock().sleep(doze);
+        hal::radioTraffic();
+        return true;
+    }
+
+    int _fd;
+    bool _eof = false;
+};
+
+int openSocket(const std::string& host, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0 || !res) return -1;
+
+    int fd = socket(res->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        int rc = ::connect(fd, res->ai_addr, res->ai_addrlen);
+        if (rc < 0 && errno == EINPROGRESS) {
+            pollfd p = { fd, POLLOUT, 0 };
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (poll(&p, 1, 3000) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) rc = 0;
+        }
+        if (rc < 0) {
+            ::close(fd);
+            fd = -1;
+        } else {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+}  // namespace
+
+void hal::redirect(const std::string& host, uint16_t port, const std::string& target) {
+    size_t colon = target.rfind(':');
+    std::string targetHost = colon == std::string::npos ? target : target.substr(0, colon);
+    uint16_t targetPort = colon == std::string::npos ? port : (uint16_t)atoi(target.c_str() + colon + 1);
+    std::lock_guard<std::mutex> guard(redirectsLock);
+    for (Redirect& r : redirects) {
+        if (r.host == host && r.port == port) {
+            r.targetHost = targetHost;
+            r.targetPort = targetPort;
+            return;
+        }
+    }
+    redirects.push_back({host, port, targetHost, targetPort});
+}
+
+void hal::redirectLoad(const std::string& spec) {
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        size_t colon = item.find(':');
+        size_t eq = item.find('=');
+        if (colon != std::string::npos && eq != std::string::npos && colon < eq) {
+            redirect(item.substr(0, colon), (uint16_t)atoi(item.c_str() + colon + 1), item.substr(eq + 1));
+        }
+        pos = end + 1;
+    }
+}
+
+bool hal::redirected(const std::string& host, uint16_t port) {
+    std::lock_guard<std::mutex> guard(redirectsLock);
+    for (const Redirect& r : redirects) {
+        if (r.port == port && (r.host == host || r.host == "*")) return true;
+    }
+    return false;
+}
+
+std::shared_ptr<hal::Conn> hal::socketConnect(const std::string& host, uint16_t port) {
+    std::string targetHost;
+    uint16_t targetPort = 0;
+    {
+        std::lock_guard<std::mutex> guard(redirectsLock);
+        const Redirect* match = nullptr;
+        for (const Redirect& r : redirects) {
+            if (r.port != port) continue;
+            if (r.host == host) { match = &r; break; }
+            if (r.host == "*") match = &r;
+        }
+        if (!match) return nullptr;
+        targetHost = match->targetHost;
+        targetPort = match->targetPort;
+    }
+    int fd = openSocket(targetHost, targetPort);
+    if (fd < 0) return nullptr;
+    return std::make_shared<SocketConn>(fd);
+}
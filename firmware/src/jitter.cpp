@@ -0,0 +1,27 @@
+#include "jitter.h"
+
+void Jitter::begin(const uint8_t mac[6], uint32_t salt) {
+    // FNV-1a sur la MAC puis le sel, mélangé pour que des MAC voisines divergent
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+    h = (h ^ salt) * 16777619u;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    _seed = h;
+    _state = h ? h : 1; // xorshift ne sort jamais de 0
+}
+
+uint32_t Jitter::next() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
+
+uint32_t Jitter::backoff(uint32_t base, uint32_t cap, uint8_t failures, uint32_t floor) {
+    uint8_t shift = failures > 0 ? min(failures - 1, 16) : 0;
+    uint32_t ceiling = (uint32_t)min((uint64_t)base << shift, (uint64_t)cap);
+    if (ceiling <= floor) return floor;
+    return floor + below(ceiling - floor + 1);
+}
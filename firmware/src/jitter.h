@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Aléa déterministe par appareil : la graine vient de la MAC, si bien que deux
+// fenêtres démarrées ensemble (retour du courant) ne tirent pas les mêmes
+// délais, et qu'un même appareil rejoue toujours la même suite. Un générateur
+// par tâche (xorshift32, sans verrou).
+class Jitter {
+public:
+    // `salt` distingue les générateurs d'un même appareil.
+    void begin(const uint8_t mac[6], uint32_t salt);
+    uint32_t next();
+    // Tirage uniforme dans [0, n), 0 si n = 0.
+    uint32_t below(uint32_t n) { return n ? next() % n : 0; }
+    // Décalage fixe de l'appareil dans [0, n) : le même à chaque démarrage.
+    uint32_t offset(uint32_t n) const { return n ? _seed % n : 0; }
+    // Attente après `failures` échecs consécutifs (>= 1), tirée dans
+    // [floor, min(cap, base × 2^(failures - 1))] (« full jitter »).
+    uint32_t backoff(uint32_t base, uint32_t cap, uint8_t failures, uint32_t floor = 0);
+
+private:
+    uint32_t _seed = 1;
+    uint32_t _state = 1;
+};
@@ -0,0 +1,63 @@
+#include "json_arena.h"
+
+bool JsonArena::begin(size_t size) {
+    reset();
+    if (_buf && size == _size) return true;
+    free(_buf);
+    _buf = nullptr;
+#ifdef BOARD_HAS_PSRAM
+    if (psramFound()) _buf = (uint8_t*)ps_malloc(size);
+#endif
+    if (!_buf) _buf = (uint8_t*)malloc(size);
+    _size = _buf ? size : 0;
+    return _buf != nullptr;
+}
+
+void* JsonArena::allocate(size_t size) {
+    size_t need = sizeof(Block) + ((size + 7) & ~(size_t)7);
+    if (_top + need > _size) {
+        _overflows++;
+        return malloc(size);
+    }
+    Block* b = (Block*)(_buf + _top);
+    b->size = size;
+    _last = _top;
+    _top += need;
+    if (_top > _high) _high = _top;
+    return b + 1;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+    // Seul le dernier bloc rend sa place ; les autres attendent reset()
+    if ((uint8_t*)header(ptr) == _buf + _last) {
+        _top = _last;
+        _last = NONE;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t size) {
+    if (!ptr) return allocate(size);
+    if (!owns(ptr)) return realloc(ptr, size);
+
+    Block* b = header(ptr);
+    if ((uint8_t*)b == _buf + _last) {
+        size_t need = sizeof(Block) + ((size + 7) & ~(size_t)7);
+        if (_last + need <= _size) {
+            b->size = size;
+            _top = _last + need;
+            if (_top > _high) _high = _top;
+            return ptr;
+        }
+    }
+    size_t old = b->size;
+    void* moved = allocate(size);
+    if (!moved) return nullptr;
+    memcpy(moved, ptr, old < size ? old : size);
+    deallocate(ptr);
+    return moved;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Allocateur ArduinoJson sur un tampon réservé une fois pour toutes : les
+// documents et corps d'un échange y vivent le temps de la requête, sans
+// allouer ni libérer sur le tas à chaque poll. Allocation en pile, libérée
+// d'un coup par reset() une fois les documents détruits. Un document plus
+// gros que le tampon déborde sur le tas (compté par overflows()).
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    // Réserve `size` octets (PSRAM si la carte en a).
+    bool begin(size_t size);
+    void reset() { _top = 0; _last = NONE; }
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t size) override;
+
+    size_t size() const { return _size; }
+    size_t highWater() const { return _high; } // plus haut niveau atteint depuis le boot
+    uint32_t overflows() const { return _overflows; }
+
+private:
+    static const size_t NONE = (size_t)-1;
+    // En-tête de bloc : garde l'alignement sur 8 octets
+    struct Block {
+        uint32_t size;
+        uint32_t pad;
+    };
+
+    bool owns(const void* ptr) const { return ptr >= _buf && ptr < _buf + _size; }
+    Block* header(void* ptr) const { return (Block*)ptr - 1; }
+
+    uint8_t* _buf = nullptr;
+    size_t _size = 0;
+    size_t _top = 0;
+    size_t _last = NONE;   // début du dernier bloc, seul à pouvoir grandir ou être rendu
+    size_t _high = 0;
+    uint32_t _overflows = 0;
+};
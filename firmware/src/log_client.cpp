@@ -0,0 +1,118 @@
+#include "log_client.h"
+
+void LogClient::begin(const char* url, uint16_t timeoutMs) {
+    _url = url;
+    // Hôte et port de l'URL, pour ouvrir le socket soi-même (DNS et connexion chronométrés)
+    const char* host = strstr(url, "://");
+    host = host ? host + 3 : url;
+    size_t len = strcspn(host, ":/");
+    snprintf(_host, sizeof(_host), "%.*s", (int)len, host);
+    _port = host[len] == ':' ? (uint16_t)atoi(host + len + 1) : 80;
+    static const char* headers[] = { "Content-Type", "Retry-After" };
+    _http.collectHeaders(headers, 2);
+    _http.setReuse(true);
+    _http.setTimeout(timeoutMs);
+}
+
+void LogClient::reset() {
+    _http.end();
+    _client.stop();
+}
+
+// Résolution puis connexion TCP ; HTTPClient reprend ensuite le socket ouvert.
+bool LogClient::open() {
+    IPAddress ip;
+    uint32_t t0 = micros();
+    if (!WiFi.hostByName(_host, ip)) return false;
+    uint32_t t1 = micros();
+    _timing.set(STAGE_DNS, t1 - t0);
+    if (!_client.connect(ip, _port)) return false;
+    _timing.set(STAGE_CONNECT, micros() - t1);
+    return true;
+}
+
+int LogClient::send(const char* url, const char* body, size_t len, char* response, size_t size) {
+    _timing.clear();
+    // Après begin(), qui coupe un socket ouvert vers un autre serveur
+    _http.begin(_client, url);
+    if (!_client.connected()) {
+        if (_connections > 0) Serial.printf("log: reconnexion (%u requêtes sur la connexion #%u)\n", (unsigned)_requestsOnConn, (unsigned)_connections);
+        _connections++;
+        _requestsOnConn = 0;
+        if (!open()) return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    _client.arm();
+    _http.addHeader("Accept", "application/msgpack, application/json;q=0.5");
+    int code;
+    if (body) {
+        _http.addHeader("Content-Type", _msgpack ? "application/msgpack" : "application/json");
+        code = _http.POST((uint8_t*)body, len);
+    } else {
+        code = _http.GET();
+    }
+    if (code <= 0) return code;
+    _responseMsgPack = _http.header("Content-Type").startsWith("application/msgpack");
+    // Backend surchargé : Retry-After en secondes (la forme date HTTP n'est pas lue)
+    if (code == 429 || code == 503) _retryAfterS = _http.header("Retry-After").toInt();
+    if (code < 300) {
+        _msgpack = _responseMsgPack && !_msgpackRefused;
+    } else if (body && _msgpack && (code == 415 || code == 406)) {
+        // Corps binaire refusé (proxy, backend partiel) : JSON jusqu'au redémarrage
+        _msgpack = false;
+        _msgpackRefused = true;
+    }
+
+    _requestsOnConn++;
+    // Corps lu en entier : le socket reste utilisable pour la requête suivante
+    if (!readBody(response, size)) return HTTPC_ERROR_READ_TIMEOUT;
+    uint32_t end = micros();
+    if (_client.firstByte()) {
+        _timing.set(STAGE_SEND, _client.sendEnd() - _client.sendStart());
+        _timing.set(STAGE_WAIT, _client.firstByte() - _client.sendEnd());
+        _timing.set(STAGE_BODY, end - _client.firstByte());
+    }
+    return code;
+}
+
+bool LogClient::readBody(char* response, size_t size) {
+    int left = _http.getSize();
+    WiFiClient* stream = _http.getStreamPtr();
+    if (left < 0 || !stream) {
+        // Corps chunked ou sans longueur (pas le cas d'Express) : lecture générique
+        String body = _http.getString();
+        _responseLength = min((size_t)body.length(), size - 1);
+        memcpy(response, body.c_str(), _responseLength);
+        response[_responseLength] = 0;
+        return true;
+    }
+    size_t n = 0;
+    char scratch[64];
+    while (left > 0) {
+        // Au-delà du tampon, la fin du corps est lue puis jetée
+        bool fits = n + 1 < size;
+        size_t want = min((size_t)left, fits ? size - 1 - n : sizeof(scratch));
+        size_t got = stream->readBytes(fits ? response + n : scratch, want);
+        if (got == 0) break;
+        if (fits) n += got;
+        left -= got;
+    }
+    response[n] = 0;
+    _responseLength = n;
+    return left == 0;
+}
+
+int LogClient::request(const char* url, const char* body, size_t len, char* response, size_t size) {
+    bool reused = _client.connected();
+    int code = send(url, body, len, response, size);
+    if (code > 0) return code;
+
+    // Un socket réutilisé a pu être fermé par le serveur (timeout keep-alive,
+    // redémarrage du backend) : on retente une fois sur une connexion neuve.
+    reset();
+    if (reused) code = send(url, body, len, response, size);
+    if (code <= 0) {
+        Serial.printf("log: échec %s (%s)\n", body ? "POST" : "GET", HTTPClient::errorToString(code).c_str());
+        reset();
+    }
+    return code;
+}
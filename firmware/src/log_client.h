@@ -0,0 +1,68 @@
+// Canal de télémétrie vers /api/window/log : un seul socket TCP gardé ouvert
+// (keep-alive) d'un poll à l'autre, rouvert uniquement après une erreur.
+// Les autres routes du même backend (lots de rattrapage) passent par ce socket.
+// URL, corps et réponse sont des tampons de l'appelant : aucune String par requête.
+// Format négocié : chaque requête accepte MessagePack ou JSON ; les corps
+// partent en MessagePack dès que le backend a répondu dans ce format, et
+// repassent en JSON s'il se remet à répondre en JSON, ou pour de bon s'il
+// refuse explicitement un corps binaire (415, 406).
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include "net_timing.h"
+
+class LogClient {
+public:
+    void begin(const char* url, uint16_t timeoutMs = 3000);
+
+    // Envoie `body` (JSON, ou MessagePack si msgpack()) et lit la réponse dans `response` (tronquée à `size` - 1 octets).
+    // Renvoie le code HTTP, ou un code HTTPC_ERROR_* (< 0) si le réseau a échoué.
+    int post(const char* body, size_t len, char* response, size_t size) { return post(_url, body, len, response, size); }
+    // Idem vers une autre URL du même serveur.
+    int post(const char* url, const char* body, size_t len, char* response, size_t size) { return request(url, body, len, response, size); }
+    // GET sur le même socket (lecture de l'ordre entre deux envois).
+    int get(const char* url, char* response, size_t size) { return request(url, nullptr, 0, response, size); }
+
+    // Ferme le socket ; le prochain post() reconnecte.
+    void reset();
+
+    // Le backend parle MessagePack : les prochains corps doivent être encodés ainsi.
+    bool msgpack() const { return _msgpack; }
+    // Format et longueur de la dernière réponse (un corps MessagePack peut contenir des 0).
+    bool responseMsgPack() const { return _responseMsgPack; }
+    size_t responseLength() const { return _responseLength; }
+    // Délai Retry-After (s) d'une réponse 429 ou 503, remis à zéro une fois lu.
+    uint32_t takeRetryAfter() {
+        uint32_t seconds = _retryAfterS;
+        _retryAfterS = 0;
+        return seconds;
+    }
+
+    uint32_t connections() const { return _connections; }
+    uint32_t requestsOnConnection() const { return _requestsOnConn; }
+    // Étapes de la dernière requête réussie (DNS et connexion si le socket était neuf ; sans parse).
+    const NetTiming& timing() const { return _timing; }
+
+private:
+    int request(const char* url, const char* body, size_t len, char* response, size_t size);
+    int send(const char* url, const char* body, size_t len, char* response, size_t size);
+    bool readBody(char* response, size_t size);
+
+    bool open();
+
+    TimedClient<WiFiClient> _client;
+    HTTPClient _http;
+    const char* _url = "";
+    char _host[64] = "";
+    uint16_t _port = 80;
+    NetTiming _timing = {};
+    bool _msgpack = false;
+    bool _msgpackRefused = false;
+    bool _responseMsgPack = false;
+    size_t _responseLength = 0;
+    uint32_t _retryAfterS = 0;
+    uint32_t _connections = 0;    // connexions ouvertes depuis le boot
+    uint32_t _requestsOnConn = 0; // requêtes servies par la connexion courante
+};
@@ -5,37 +5,350 @@
 #include <ESP32Servo.h>
 #include <NimBLEDevice.h>
 #include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+#include "jitter.h"
+#include "json_arena.h"
+#include "log_client.h"
+#include "net_timing.h"
+#include "power.h"
+#include "sample_ring.h"
+#include "telemetry_store.h"
+#include "weather_client.h"
+#include "window_motion.h"
+#include "window_rules.h"
+
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "dev" // -DFIRMWARE_VERSION=\"x.y.z\" à la compilation
+#endif
 
 #define SERVO_PIN 13 
+#define WINDOW_CLOSED_US 500  // 0°
+#define WINDOW_OPEN_US 1450   // 90°
 Servo windowServo;
+WindowMotion windowMotion;
 Preferences preferences;
+LogClient logClient;
+LogClient pushClient; // connexion dédiée au long-poll des ordres
+WeatherClient weatherClient;
+TelemetryStore telemetry;
+SampleRing pendingSamples;
+PowerManager power;
 
 // UUIDs BLE
 #define SERVICE_UUID        "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
 #define CHAR_CONFIG_UUID    "beb5483e-36e1-4688-b7f5-ea07361b26a8" 
-String API_URL = "http://10.55.71.14:3001/api/window/log";
+#define CHAR_RULES_UUID     "beb5483e-36e1-4688-b7f5-ea07361b26a9" // règles du mode AUTO, appliquées sans redémarrage
+const char* API_URL = "http://10.55.71.14:3001/api/window/log";
+const char* API_BATCH_URL = "http://10.55.71.14:3001/api/window/log/batch";
+const char* API_COMMAND_URL = "http://10.55.71.14:3001/api/window/command";
+#define TELEMETRY_BACKLOG 2048 // échantillons gardés en flash pendant une coupure (≈ 68 min à 2 s), clé "backlog"
+#define TELEMETRY_BATCH 32     // échantillons renvoyés par requête au retour du backend
+#define SAMPLE_RING_SIZE 1024  // anneau PSRAM du mode lots (16 Ko)
+
+// Poll sans tas : documents JSON et corps des requêtes dans une arène réservée
+// au démarrage (taille selon le plus gros lot possible), réponses dans un
+// tampon fixe. Les réponses du backend font moins de 100 octets.
+#define NET_ARENA_BASE 3072
+#define NET_ARENA_PER_SAMPLE 192 // document ArduinoJson + JSON sérialisé
+#define RESPONSE_SIZE 256
+JsonArena netArena;
+
+// Latence des deux échanges du poll, étape par étape (DNS, connexion, TLS,
+// envoi, attente du premier octet, corps, parsing) : histogrammes glissants.
+NetStats logNet;
+NetStats weatherNet;
+
+// Compteurs (tx, météo, servo, poll, provisionnement, énergie, tas) et résumé
+// réseau : joints à un envoi par STATS_MS, le poll ne porte sinon que
+// l'échantillon. Le bloc `boot` ne change plus après le démarrage : il part
+// une fois, avec le délai de la première télémétrie.
+#define STATS_MS 60000
+unsigned long lastStats = 0;
+bool statsDue = true;     // au premier envoi, et après un envoi refusé
+bool bootPending = true;  // bloc boot pas encore reçu par le backend
+
+// Mode lots (clés "batch" et "batchT") : 0 ou 1 = un POST par poll, comme avant
+uint32_t batchSize = 0;
+unsigned long batchPeriodMs = 30000;
+unsigned long lastBatchExchange = 0;  // dernier lot posté ou dernier ordre relu
+bool lastBatchOpen = false;
+
+// Canal push : un long-poll tenu en permanence sur GET /api/window/command.
+// Tant qu'il répond, les ordres arrivent sans attendre le poll, et le poll
+// n'envoie plus que la télémétrie, par lots de PUSH_BATCH.
+#define PUSH_WAIT_S 25 // durée max d'un long-poll côté backend
+#define PUSH_BATCH 15
+volatile bool pushAlive = false;
+TaskHandle_t pushTaskHandle = nullptr;
+JsonArena pushArena;
+
+// Dernier ordre connu et sa version côté backend (0 : backend sans versions).
+// Écrit par la tâche réseau et la tâche push, d'où le mutex.
+struct KnownCommand {
+    char command[8];
+    uint8_t position; // ouverture demandée avec OPEN, en %
+    uint64_t version;
+};
+KnownCommand knownCommand = { "AUTO", 100, 0 };
+SemaphoreHandle_t commandLock;
 String wifi_ssid = "";
 String wifi_pass = "";
 float latitude = 45.18;
 float longitude = 5.72;
+volatile bool wifiConfigured = false; // lu par la tâche réseau (wifi_ssid appartient à loop())
+
+// Configuration reçue par BLE, appliquée par loop() sans redémarrage : WiFi
+// rebranché seulement si les identifiants changent, météo relue seulement si
+// les coordonnées changent. Chaque application ouvre une génération ; le
+// premier échange réussi de cette génération (avec la météo des nouvelles
+// coordonnées) clôt la mesure du temps jusqu'à l'état opérationnel.
+struct ConfigEvent {
+    char ssid[33];
+    char pass[65];
+    float lat;
+    float lon;
+};
+QueueHandle_t configEvents;
+uint32_t configGen = 0;
+uint32_t coordsGen = 0;
+uint32_t weatherCoordsGen = 0; // coordonnées de la dernière météo (tâche réseau)
+unsigned long provisionAt = 0;
+bool provisioning = false;      // configuration appliquée, pas encore opérationnelle
+bool pollNow = false;
+// Dernière association réussie : canal, BSSID et bail du point d'accès, pour
+// une connexion dirigée (sans scan) au démarrage suivant. Gardée avec le SSID
+// auquel elle correspond ; réécrite seulement si elle change.
+struct WifiCache {
+    char ssid[33];
+    int32_t channel;  // 0 : pas de cache
+    uint8_t bssid[6];
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+};
+WifiCache wifiCache = {};
+bool fastIp = false; // clé "fastIp" : réutilise aussi l'adresse (pas de DHCP)
+#define WIFI_DIRECTED_TIMEOUT_MS 1500 // sans association au-delà, le point d'accès a changé de canal : scan
+enum WifiAttempt : uint8_t { WIFI_IDLE, WIFI_DIRECTED, WIFI_SCAN };
+WifiAttempt wifiAttempt = WIFI_IDLE;
+bool wifiStaticIp = false;
+unsigned long wifiAttemptAt = 0;
+
+// Démarrage, en ms depuis le boot : association WiFi, première télémétrie acceptée
+struct BootStats {
+    uint32_t count;      // démarrages (clé "boots")
+    uint32_t wifiMs;
+    uint32_t telemetryMs;
+    bool fast;           // première association par connexion dirigée
+    uint32_t fallbacks;  // connexions dirigées abandonnées pour un scan
+};
+BootStats bootStats = {};
+
+struct ProvisionStats {
+    uint32_t applies;
+    uint32_t lastMs; // dernière configuration → premier échange opérationnel
+};
+ProvisionStats provisionStats = {};
 bool isOpen = false;
+uint8_t opening = 0; // ouverture visée, en % (isOpen : opening > 0)
+
+// Période du poll (clé "pollMs") : réactivité aux ordres contre charge du backend
+unsigned long pollPeriodMs = 2000;
+// Cadence dictée par le backend : `nextPollMs` de ses réponses remplace pollMs
+// tant qu'il est présent (accéléré quand un utilisateur pilote la fenêtre,
+// ralenti sous la charge) ; `retryAfter` (s, champ ou en-tête Retry-After
+// d'un 429/503) suspend le poll une fois. Écrits par la tâche réseau.
+#define POLL_MIN_MS 500
+#define POLL_MAX_MS 60000
+#define RETRY_AFTER_MAX_S 600
+volatile uint32_t serverPollMs = 0; // 0 : pollPeriodMs
+volatile uint32_t pollHoldMs = 0;   // pause avant le prochain poll, 0 : aucune
+uint32_t pollHolds = 0;
+// Étalement de la flotte (générateurs tirés de la MAC) : chaque tour de poll
+// est étiré de ±pollJitterPct % (clé "jitter", 0 : grille fixe), le premier
+// poll après l'association tombe au hasard dans la période, et un poll en
+// échec recule en « full jitter » (tirage dans une fenêtre qui double jusqu'à
+// POLL_BACKOFF_MAX_MS). La météo est relue avec un retard propre à l'appareil.
+#define POLL_BACKOFF_MAX_MS 60000
+#define WEATHER_SPREAD_S 120
+#define PUSH_BACKOFF_MAX_MS 60000
+uint8_t pollJitterPct = 10;
+Jitter pollJitter;  // loop()
+Jitter netJitter;   // tâche réseau
+Jitter pushJitter;  // tâche push
+unsigned long lastPoll = 0;
+int16_t pollSkew = 0;        // étirement du tour en cours, en ‰
+unsigned long pollStartMs = 0; // attente du premier poll après association, 0 : aucune
+uint8_t pollFailures = 0;    // polls en échec consécutifs (tâche réseau)
 
 // Variables pour stocker la dernière météo (pour éviter de spammer l'API météo)
 float lastTemp = 0.0;
 int lastAQI = 0;
+// Champs lus seulement si une règle les utilise (NAN sinon)
+float lastWind = NAN;
+float lastRain = NAN;
+float lastHumidity = NAN;
 unsigned long lastWeatherCheck = 0;
+bool weatherKnown = false; // au moins une météo lue : lastTemp/lastAQI sont de vraies mesures
+
+// Rafraîchissement météo calé sur Open-Meteo : les valeurs "current" ne
+// changent qu'une fois par `interval` (900 s), à l'heure `time`. On relit peu
+// après l'échéance suivante plutôt que toutes les minutes ; une réponse pas
+// encore à jour est relue avec un délai croissant, une erreur aussi.
+#define WEATHER_MIN_S 60          // plancher (et période tant que l'heure NTP manque)
+#define WEATHER_LAG_S 60          // publication après l'échéance
+#define WEATHER_MAX_S 3600
+#define WEATHER_RETRY_MAX_S 900   // plafond du délai après erreur
+uint32_t weatherDelayS = 0;       // délai courant depuis lastWeatherCheck (0 : tout de suite)
+uint32_t weatherUpstream = 0;     // `time` de la dernière réponse (epoch), 0 si absente
+uint32_t weatherInterval = 0;
+uint8_t weatherFailures = 0;      // erreurs consécutives
+uint8_t weatherStale = 0;         // réponses consécutives déjà échues
+// Décalage de l'heure locale aux coordonnées (heure d'été comprise), donné par
+// Open-Meteo (timezone=auto) : l'heure des règles en dépend, pas de TZ à régler.
+volatile int32_t localOffsetS = 0;
+volatile bool localOffsetKnown = false;
+
+// Règles du mode AUTO (clé "rules", caractéristique BLE CHAR_RULES_UUID).
+// Évaluées dans loop(), remplacées depuis la tâche BLE : d'où le mutex.
+RuleSet rules;
+String rulesText;
+SemaphoreHandle_t rulesLock;
+volatile uint8_t rulesUses = 0; // grandeurs lues, pour la requête météo
+volatile bool rulesUnsaved = false; // règles BLE pas encore écrites en NVS
+uint8_t weatherUses = 0;         // grandeurs de la dernière requête météo, même en échec (tâche réseau)
+
+// Anti-battement du mode AUTO. Bandes d'hystérésis des règles par grandeur
+// (clés "hystTemp", "hystAqi", "hystWind") et durées minimales avant de
+// repartir dans l'autre sens : "holdOpen" (s) ouverte avant qu'AUTO ne
+// referme, "holdClosed" (s) fermée avant qu'AUTO ne rouvre. Les ordres
+// manuels passent outre.
+float hysteresis[RULE_VAR_COUNT] = { 1.0, 5, 5, 0, 0, 0 };
+unsigned long holdOpenMs = 120000;
+unsigned long holdClosedMs = 600000;
+unsigned long lastMoveAt = 0;
+int8_t lastMoveDir = 0; // dernier mouvement d'AUTO : 1 ouverture, -1 fermeture, 0 aucun (ou ordre manuel depuis)
+bool autoHeld = false;
+// Actionnements depuis le boot, remontés au backend (usure, consommation)
+struct ActStats {
+    uint32_t opens;  // mouvements vers l'ouverture
+    uint32_t closes; // mouvements vers la fermeture
+    uint32_t travel; // course cumulée, en %
+    uint32_t held;   // décisions AUTO retardées par la durée minimale
+};
+ActStats actStats = {};
+
+// Envoi sur changement (clés "dbTemp", "dbAqi", "heartbeat") : un échantillon
+// ne part que si la fenêtre a bougé, si une valeur sort de la bande morte par
+// rapport au dernier envoyé, ou au bout du battement de cœur. Bandes à 0 :
+// tout part, comme avant.
+float deadbandTemp = 0.2;
+int deadbandAqi = 2;
+unsigned long heartbeatMs = 300000;
+struct SentSample {
+    float temp;
+    int aqi;
+    bool isOpen;
+    unsigned long at;
+    bool valid;
+};
+SentSample lastSent = {};
+// Compteurs remontés au backend pour mesurer le gain
+struct TxStats {
+    uint32_t sent;       // échantillons retenus (envoyés, en lot ou en flash)
+    uint32_t suppressed; // échantillons écartés par la bande morte
+    uint32_t bytes;      // octets de corps postés (JSON ou MessagePack)
+};
+TxStats txStats = {};
+
+// Tâche réseau (cœur 0, avec la pile WiFi) : loop() ne fait plus d'I/O réseau.
+// Il dépose un instantané de l'état dans netJobs et applique les résultats
+// reçus sur loopEvents, si bien qu'un DNS ou un handshake TLS lent ne fige
+// plus ni le servo ni le BLE.
+struct NetJob {
+    bool isOpen;
+    uint8_t opening;
+    uint32_t configGen;
+    uint32_t coordsGen;
+    bool weatherOnly; // échéance météo : relecture d'Open-Meteo sans échange avec le backend
+};
+struct NetResult {
+    float temp;
+    int aqi;
+    float wind;
+    float rain;
+    float humidity;
+    char command[8];
+    uint8_t position;
+    uint32_t configGen; // génération servie, 0 si la météo n'est pas encore la sienne
+};
+QueueHandle_t netJobs;
+TaskHandle_t netTaskHandle = nullptr;
+bool netThreaded = false;
+
+// loop() dort sur loopEvents jusqu'au prochain événement : échéance du poll ou
+// de la météo (timers FreeRTOS), suivi de l'association WiFi, configuration
+// ou règles BLE, ordre reçu (tâche réseau ou push). Les rappels des timers ne
+// font que réveiller loop(), qui fait le travail. Configuration et règles
+// attendent dans leur propre boîte (configEvents, rulesUnsaved), relue à chaque
+// réveil : l'événement perdu quand la file est pleine ne perd pas l'écriture.
+enum LoopEventType : uint8_t { EVENT_POLL, EVENT_WEATHER, EVENT_WIFI, EVENT_CONFIG, EVENT_RULES, EVENT_COMMAND };
+struct LoopEvent {
+    LoopEventType type;
+    NetResult result; // EVENT_COMMAND
+};
+#define LOOP_EVENTS 8
+#define WIFI_CHECK_MS 100 // cadence du suivi, seulement pendant une association
+QueueHandle_t loopEvents;
+TimerHandle_t pollTimer;
+TimerHandle_t weatherTimer;
+TimerHandle_t wifiTimer;
+
+void postEvent(LoopEventType type) {
+    LoopEvent event = {};
+    event.type = type;
+    xQueueSend(loopEvents, &event, 0);
+}
+
+void postResult(const NetResult& result) {
+    LoopEvent event = { EVENT_COMMAND, result };
+    xQueueSend(loopEvents, &event, 0);
+}
+
+void onTimer(TimerHandle_t timer) {
+    postEvent((LoopEventType)(uintptr_t)pvTimerGetTimerID(timer));
+}
+
+// Fixe l'ouverture visée ; le mouvement se fait en arrière-plan (WindowMotion).
+void setOpening(uint8_t percent) {
+    percent = min(percent, (uint8_t)100);
+    if (opening == percent) return;
+    if (percent > opening) actStats.opens++;
+    else actStats.closes++;
+    actStats.travel += abs((int)percent - (int)opening);
+    windowMotion.moveTo(percent);
+    opening = percent;
+    isOpen = percent > 0;
+}
 
 void setWindow(bool open) {
-    if (isOpen == open) return;
-    if (open) {
-        windowServo.write(90); 
-    } else {
-        windowServo.write(0);
-    }
-    isOpen = open;
+    setOpening(open ? 100 : 0);
 }
 
-// ... (Code BLE inchangé, je le condense pour la lisibilité)
+// Le mode AUTO peut-il aller vers `percent` ? Pas de demi-tour avant la durée
+// minimale dans la position atteinte par son propre dernier mouvement.
+bool autoMayMove(uint8_t percent) {
+    int8_t dir = percent > opening ? 1 : -1;
+    if (lastMoveDir == 0 || dir == lastMoveDir) return true;
+    return millis() - lastMoveAt >= (dir > 0 ? holdClosedMs : holdOpenMs);
+}
+
+// "ssid;pass;lat;lon" : transmis à loop(), qui l'applique (tâche BLE ici)
 class ConfigCallbacks: public BLECharacteristicCallbacks {
     void onWrite(BLECharacteristic *pCharacteristic) {
       std::string value = pCharacteristic->getValue();
@@ -43,75 +356,781 @@ class ConfigCallbacks: public BLECharacteristicCallbacks {
         String data = String(value.c_str());
         int s1 = data.indexOf(';'); int s2 = data.indexOf(';', s1+1); int s3 = data.indexOf(';', s2+1);
         if(s3 > 0) {
-            wifi_ssid = data.substring(0, s1); wifi_pass = data.substring(s1+1, s2);
-            latitude = data.substring(s2+1, s3).toFloat(); longitude = data.substring(s3+1).toFloat();
+            ConfigEvent cfg;
+            snprintf(cfg.ssid, sizeof(cfg.ssid), "%s", data.substring(0, s1).c_str());
+            snprintf(cfg.pass, sizeof(cfg.pass), "%s", data.substring(s1+1, s2).c_str());
+            cfg.lat = data.substring(s2+1, s3).toFloat(); cfg.lon = data.substring(s3+1).toFloat();
+            xQueueOverwrite(configEvents, &cfg);
+            postEvent(EVENT_CONFIG);
+        }
+      }
+    }
+};
+
+// Connexion au réseau configuré : dirigée sur le canal et le BSSID mémorisés
+// s'il y en a pour ce SSID (ni scan, ni DHCP avec fastIp), scan sinon.
+void wifiConnect() {
+    bool cached = wifiCache.channel > 0 && wifi_ssid == wifiCache.ssid;
+    bool staticIp = cached && fastIp && wifiCache.ip != 0;
+    if (staticIp) {
+        WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway), IPAddress(wifiCache.mask), IPAddress(wifiCache.dns));
+    } else if (wifiStaticIp) {
+        WiFi.config(IPAddress(), IPAddress(), IPAddress()); // retour au DHCP
+    }
+    wifiStaticIp = staticIp;
+    // Configuration sans connexion, pour y glisser l'intervalle d'écoute avant la requête d'association
+    if (cached) WiFi.begin(wifi_ssid.c_str(), wifi_pass.c_str(), wifiCache.channel, wifiCache.bssid, false);
+    else WiFi.begin(wifi_ssid.c_str(), wifi_pass.c_str(), 0, nullptr, false);
+    power.applyListen();
+    esp_wifi_connect();
+    wifiAttempt = cached ? WIFI_DIRECTED : WIFI_SCAN;
+    wifiAttemptAt = millis();
+    xTimerStart(wifiTimer, 0);
+}
+
+// Suivi de l'association en cours (loop(), toutes les WIFI_CHECK_MS) : repli
+// sur un scan si la connexion dirigée n'aboutit pas, mise à jour du cache une
+// fois associé.
+void wifiService() {
+    if (wifiAttempt == WIFI_IDLE) {
+        xTimerStop(wifiTimer, 0);
+        return;
+    }
+    wl_status_t status = WiFi.status();
+    if (status == WL_CONNECTED) {
+        bool directed = wifiAttempt == WIFI_DIRECTED;
+        wifiAttempt = WIFI_IDLE;
+        xTimerStop(wifiTimer, 0);
+        power.applyWifi();
+        // Premier échange sans attendre une période entière, mais pas à la
+        // même milliseconde que les voisins revenus avec le courant
+        if (pollJitterPct) {
+            lastPoll = millis();
+            pollStartMs = 1 + pollJitter.below(pollPeriodMs);
+        } else {
+            pollNow = true;
+        }
+        Serial.printf("WiFi: associé en %lu ms (%s)\n", millis() - wifiAttemptAt, directed ? "connexion dirigée" : "scan");
+        if (!bootStats.wifiMs) {
+            bootStats.wifiMs = millis();
+            bootStats.fast = directed;
+        }
+        WifiCache next = {};
+        snprintf(next.ssid, sizeof(next.ssid), "%s", wifi_ssid.c_str());
+        next.channel = WiFi.channel();
+        const uint8_t* bssid = WiFi.BSSID();
+        if (bssid) memcpy(next.bssid, bssid, sizeof(next.bssid));
+        next.ip = WiFi.localIP();
+        next.gateway = WiFi.gatewayIP();
+        next.mask = WiFi.subnetMask();
+        next.dns = WiFi.dnsIP();
+        if (memcmp(&next, &wifiCache, sizeof(next)) != 0) {
+            wifiCache = next;
             preferences.begin("config", false);
-            preferences.putString("ssid", wifi_ssid); preferences.putString("pass", wifi_pass);
-            preferences.putFloat("lat", latitude); preferences.putFloat("lon", longitude);
+            preferences.putBytes("wifiCache", &wifiCache, sizeof(wifiCache));
             preferences.end();
-            ESP.restart();
         }
-      }
+        return;
+    }
+    // Délai compté jusqu'à l'association au point d'accès, pas jusqu'au bail :
+    // un DHCP lent n'invalide pas le cache
+    wifi_ap_record_t ap;
+    bool linked = esp_wifi_sta_get_ap_info(&ap) == ESP_OK;
+    if (wifiAttempt == WIFI_DIRECTED && !linked &&
+        (status == WL_NO_SSID_AVAIL || millis() - wifiAttemptAt > WIFI_DIRECTED_TIMEOUT_MS)) {
+        // Point d'accès changé (canal, BSSID) : le cache est périmé
+        Serial.println("WiFi: connexion dirigée sans réponse, scan complet");
+        bootStats.fallbacks++;
+        wifiCache.channel = 0;
+        unsigned long startedAt = wifiAttemptAt;
+        WiFi.disconnect();
+        wifiConnect();
+        wifiAttemptAt = startedAt; // durée comptée depuis la première tentative
+    }
+}
+
+// Exécuté dans loop() : enregistre la configuration et n'en refait que ce qui a changé.
+void applyConfig(const ConfigEvent& cfg) {
+    bool credentials = wifi_ssid != cfg.ssid || wifi_pass != cfg.pass;
+    bool coords = latitude != cfg.lat || longitude != cfg.lon;
+    preferences.begin("config", false);
+    preferences.putString("ssid", cfg.ssid); preferences.putString("pass", cfg.pass);
+    preferences.putFloat("lat", cfg.lat); preferences.putFloat("lon", cfg.lon);
+    preferences.end();
+
+    if (coords) {
+        // Lues par la tâche réseau après le prochain job, qui porte la nouvelle génération
+        latitude = cfg.lat;
+        longitude = cfg.lon;
+        coordsGen++;
+    }
+    if (credentials) {
+        wifi_ssid = cfg.ssid;
+        wifi_pass = cfg.pass;
+        WiFi.disconnect();
+        if (wifi_ssid.length() > 0) wifiConnect();
+        else wifiAttempt = WIFI_IDLE;
+        wifiConfigured = wifi_ssid.length() > 0;
+    }
+    configGen++;
+    provisionStats.applies++;
+    provisionAt = millis();
+    provisioning = true;
+    pollNow = true;
+    Serial.printf("Configuration appliquée sans redémarrage (WiFi %s, coordonnées %s)\n",
+                  credentials ? "rebranché" : "inchangé", coords ? "nouvelles" : "inchangées");
+}
+
+// Remplace les règles en service (texte déjà compilé dans `next`).
+void installRules(const RuleSet& next, const String& text) {
+    xSemaphoreTake(rulesLock, portMAX_DELAY);
+    rules = next;
+    for (int var = 0; var < RULE_VAR_COUNT; var++) rules.setHysteresis((RuleVar)var, hysteresis[var]);
+    rulesText = text;
+    rulesUses = next.uses();
+    xSemaphoreGive(rulesLock);
+}
+
+// Règles en service écrites en NVS (loop(), après une écriture BLE).
+void saveRules() {
+    xSemaphoreTake(rulesLock, portMAX_DELAY);
+    String text = rulesText;
+    xSemaphoreGive(rulesLock);
+    preferences.begin("config", false);
+    preferences.putString("rules", text);
+    preferences.end();
+}
+
+class RulesCallbacks: public BLECharacteristicCallbacks {
+    void onWrite(BLECharacteristic *pCharacteristic) {
+        std::string value = pCharacteristic->getValue();
+        RuleSet next;
+        char error[48];
+        if (!next.compile(value.c_str(), error, sizeof(error))) {
+            // Relu par l'application : les règles en service restent
+            Serial.printf("Règles refusées : %s\n", error);
+            pCharacteristic->setValue(std::string("ERR ") + error);
+            return;
+        }
+        bool newFields = next.uses() & ~rulesUses;
+        installRules(next, String(value.c_str()));
+        // Vent, pluie ou humidité pas encore demandés : relus sans attendre l'échéance
+        if (newFields) postEvent(EVENT_WEATHER);
+        // En NVS depuis loop(), seule tâche à se servir de `preferences`
+        rulesUnsaved = true;
+        postEvent(EVENT_RULES);
+        Serial.printf("Règles appliquées : %u conditions, %u termes\n", (unsigned)next.conditions(), (unsigned)next.terms());
     }
 };
 
-void checkSystem() {
-    if(WiFi.status() != WL_CONNECTED) return;
-
-    // 1. Récupération Météo (Toutes les 60 secondes seulement pour pas saturer)
-    if (millis() - lastWeatherCheck > 60000 || lastWeatherCheck == 0) {
-        HTTPClient http;
-        http.begin("https://api.open-meteo.com/v1/forecast?latitude=" + String(latitude) + "&longitude=" + String(longitude) + "&current=temperature_2m,european_aqi");
-        int code = http.GET();
-        if (code > 0) {
-            String payload = http.getString();
-            JsonDocument doc; deserializeJson(doc, payload);
-            lastTemp = doc["current"]["temperature_2m"];
-            lastAQI = doc["current"]["european_aqi"];
-            if (doc["current"]["european_aqi"].isNull()) lastAQI = 20;
+// Champs "current" demandés à Open-Meteo : l'URL et le filtre de parsing sont
+// construits depuis cette liste, un nouveau champ ne s'ajoute qu'ici. Au-delà
+// de la température et de l'AQI (toujours envoyés au backend), un champ n'est
+// demandé que si une règle le lit.
+struct WeatherField {
+    const char* name;
+    RuleVar var;
+};
+const WeatherField WEATHER_FIELDS[] = {
+    { "temperature_2m", RULE_TEMP },
+    { "european_aqi", RULE_AQI },
+    { "wind_speed_10m", RULE_WIND },
+    { "precipitation", RULE_RAIN },
+    { "relative_humidity_2m", RULE_HUMIDITY },
+};
+JsonDocument weatherFilter;
+
+// "2025-06-01T12:15" (heure du fuseau de la réponse) en secondes epoch, 0 si illisible.
+uint32_t isoMinuteToEpoch(const char* iso) {
+    int y, mo, d, h, mi;
+    if (sscanf(iso, "%4d-%2d-%2dT%2d:%2d", &y, &mo, &d, &h, &mi) != 5 || mo < 1 || mo > 12) return 0;
+    // Jours depuis 1970-01-01 (calendrier grégorien, mois comptés depuis mars)
+    y -= mo <= 2;
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long days = era * 146097L + doe - 719468;
+    return (uint32_t)(days * 86400L + h * 3600L + mi * 60L);
+}
+
+// true si la météo a été relue.
+bool fetchWeather() {
+    char path[192];
+    int len = snprintf(path, sizeof(path), "/v1/forecast?latitude=%.2f&longitude=%.2f&current=", latitude, longitude);
+    uint8_t uses = rulesUses;
+    weatherUses = uses; // un échec suit le recul normal, sans relance à chaque poll
+    bool first = true;
+    for (const WeatherField& field : WEATHER_FIELDS) {
+        if (field.var > RULE_AQI && !(uses & (1 << field.var))) continue;
+        if (len < (int)sizeof(path)) len += snprintf(path + len, sizeof(path) - len, "%s%s", first ? "" : ",", field.name);
+        first = false;
+    }
+    // `time` et utc_offset_seconds en heure locale des coordonnées
+    if (len < (int)sizeof(path)) snprintf(path + len, sizeof(path) - len, "&timezone=auto");
+
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t handshakes = weatherClient.stats().handshakes;
+    JsonDocument doc(&netArena);
+    DeserializationError err;
+    int code = weatherClient.fetch(path, doc, weatherFilter, err);
+    if (code <= 0) {
+        Serial.printf("Météo: échec GET (%s)\n", HTTPClient::errorToString(code).c_str());
+        return false;
+    }
+    if (code == HTTP_CODE_OK && !err) {
+        weatherNet.record(weatherClient.timing());
+        const char* stamp = doc["current"]["time"] | "";
+        weatherUpstream = isoMinuteToEpoch(stamp);
+        localOffsetS = doc["utc_offset_seconds"] | 0;
+        localOffsetKnown = true;
+        if (weatherUpstream) weatherUpstream -= localOffsetS;
+        weatherInterval = doc["current"]["interval"] | 0;
+        lastTemp = doc["current"]["temperature_2m"];
+        lastAQI = doc["current"]["european_aqi"] | 20;
+        lastWind = doc["current"]["wind_speed_10m"] | NAN;
+        lastRain = doc["current"]["precipitation"] | NAN;
+        lastHumidity = doc["current"]["relative_humidity_2m"] | NAN;
+        weatherKnown = true;
+    }
+
+    const WeatherStats& ws = weatherClient.stats();
+    int32_t heapHeld = (int32_t)(heapBefore - ESP.getFreeHeap());
+    if (ws.handshakes != handshakes) Serial.printf("Météo: handshake %u ms, requête %u ms", (unsigned)ws.handshakeMs, (unsigned)ws.coldMs);
+    else Serial.printf("Météo: connexion gardée, requête %u ms", (unsigned)ws.warmMs);
+    Serial.printf(", parsing %u µs, %d octets de tas (min libre %u) %s\n",
+                  (unsigned)ws.parseUs, (int)heapHeld, (unsigned)ESP.getMinFreeHeap(), err.c_str());
+    return code == HTTP_CODE_OK && !err;
+}
+
+// Heure réelle (NTP) en secondes, 0 tant qu'elle n'est pas connue.
+uint32_t epochNow() {
+    time_t now = time(nullptr);
+    return now > 1600000000 ? (uint32_t)now : 0;
+}
+
+// Un échantillon différé (flash) doit porter une vraie mesure et sa date :
+// sans elles, le backend le prendrait pour l'état courant à son arrivée.
+bool sampleStorable(uint32_t ts) {
+    return weatherKnown && ts;
+}
+
+void addSample(JsonArray samples, const TelemetryRecord& r) {
+    JsonObject s = samples.add<JsonObject>();
+    if (r.ts) s["ts"] = r.ts;
+    s["temp"] = r.temp10 / 10.0;
+    s["aqi"] = r.aqi;
+    s["isOpen"] = r.isOpen != 0;
+}
+
+// Décide si l'échantillon courant part ; retenu, il devient la référence de la bande morte.
+bool sampleDue(bool open) {
+    unsigned long now = millis();
+    bool due = !lastSent.valid || open != lastSent.isOpen ||
+               fabsf(lastTemp - lastSent.temp) >= deadbandTemp ||
+               abs(lastAQI - lastSent.aqi) >= deadbandAqi ||
+               now - lastSent.at >= heartbeatMs;
+    if (!due) {
+        txStats.suppressed++;
+        return false;
+    }
+    lastSent = { lastTemp, lastAQI, open, now, true };
+    txStats.sent++;
+    return true;
+}
+
+// Joint les compteurs à `doc` s'ils sont dus (voir STATS_MS).
+void addStats(JsonDocument& doc) {
+    if (!statsDue && millis() - lastStats < STATS_MS) return;
+    lastStats = millis();
+    statsDue = false;
+
+    JsonObject tx = doc["tx"].to<JsonObject>();
+    tx["sent"] = txStats.sent;
+    tx["suppressed"] = txStats.suppressed;
+    tx["bytes"] = txStats.bytes;
+    tx["format"] = logClient.msgpack() ? "msgpack" : "json";
+
+    const WeatherStats& ws = weatherClient.stats();
+    JsonObject weather = doc["weather"].to<JsonObject>();
+    weather["fetches"] = ws.fetches;
+    weather["handshakes"] = ws.handshakes;
+    weather["handshakeMs"] = ws.handshakeMs;
+    weather["coldMs"] = ws.coldMs;
+    weather["warmMs"] = ws.warmMs;
+    weather["refreshS"] = weatherDelayS;
+
+    JsonObject act = doc["act"].to<JsonObject>();
+    act["opens"] = actStats.opens;
+    act["closes"] = actStats.closes;
+    act["travel"] = actStats.travel;
+    act["held"] = actStats.held;
+
+    JsonObject poll = doc["poll"].to<JsonObject>();
+    poll["ms"] = serverPollMs ? serverPollMs : pollPeriodMs;
+    poll["holds"] = pollHolds;
+
+    JsonObject provision = doc["provision"].to<JsonObject>();
+    provision["applies"] = provisionStats.applies;
+    provision["lastMs"] = provisionStats.lastMs;
+
+    JsonObject pm = doc["power"].to<JsonObject>();
+    pm["mode"] = power.mode();
+    pm["listen"] = power.listen();
+    pm["awakePct"] = power.awakePermille() / 10.0;
+
+    // {"log": {"dns": [n, p50, p90], ...}, "weather": {...}}, durées en µs
+    JsonObject net = doc["net"].to<JsonObject>();
+    logNet.summary(net["log"].to<JsonObject>());
+    weatherNet.summary(net["weather"].to<JsonObject>());
+
+    if (bootPending && bootStats.telemetryMs) {
+        JsonObject boot = doc["boot"].to<JsonObject>();
+        boot["fw"] = FIRMWARE_VERSION;
+        boot["n"] = bootStats.count;
+        boot["wifiMs"] = bootStats.wifiMs;
+        boot["telemetryMs"] = bootStats.telemetryMs;
+        boot["fast"] = bootStats.fast;
+        boot["fallbacks"] = bootStats.fallbacks;
+    }
+
+    // Fragmentation : un plus gros bloc qui fond alors que le libre reste stable
+    JsonObject heap = doc["heap"].to<JsonObject>();
+    heap["free"] = ESP.getFreeHeap();
+    heap["minFree"] = ESP.getMinFreeHeap();
+    heap["maxBlock"] = ESP.getMaxAllocHeap();
+    heap["arenaHigh"] = netArena.highWater();
+    heap["arenaOverflows"] = netArena.overflows();
+}
+
+// Retient l'ordre s'il n'est pas plus ancien que celui connu : une réponse du
+// poll partie avant un changement peut arriver après le push. `force` : le
+// canal push fait foi (backend redémarré, versions reparties de zéro).
+// Renvoie true si l'ordre a changé.
+bool updateCommand(const char* command, int position, uint64_t version, bool force) {
+    uint8_t percent = constrain(position, 0, 100);
+    xSemaphoreTake(commandLock, portMAX_DELAY);
+    bool changed = false;
+    if (force || version >= knownCommand.version) {
+        changed = strcmp(command, knownCommand.command) != 0 || percent != knownCommand.position;
+        snprintf(knownCommand.command, sizeof(knownCommand.command), "%s", command);
+        knownCommand.position = percent;
+        knownCommand.version = version;
+    }
+    xSemaphoreGive(commandLock);
+    return changed;
+}
+
+KnownCommand currentCommand() {
+    xSemaphoreTake(commandLock, portMAX_DELAY);
+    KnownCommand known = knownCommand;
+    xSemaphoreGive(commandLock);
+    return known;
+}
+
+void fillResult(NetResult& result) {
+    KnownCommand known = currentCommand();
+    memcpy(result.command, known.command, sizeof(result.command));
+    result.position = known.position;
+    result.temp = lastTemp;
+    result.aqi = lastAQI;
+    result.wind = lastWind;
+    result.rain = lastRain;
+    result.humidity = lastHumidity;
+    result.configGen = 0;
+}
+
+// Réponse du backend dans le format qu'il a choisi (en-tête Content-Type).
+DeserializationError parseResponse(JsonDocument& doc, const LogClient& client, const char* response) {
+    if (client.responseMsgPack()) return deserializeMsgPack(doc, response, client.responseLength());
+    return deserializeJson(doc, response, client.responseLength());
+}
+
+// Pause demandée par le backend, bornée.
+void holdPoll(uint32_t seconds) {
+    pollHoldMs = min(seconds, (uint32_t)RETRY_AFTER_MAX_S) * 1000;
+    pollHolds++;
+    Serial.printf("Backend chargé : prochain poll dans %u s\n", (unsigned)(pollHoldMs / 1000));
+}
+
+// On lit l'ordre du serveur : "AUTO", "OPEN" ou "CLOSE"
+void readCommand(const char* response, NetResult& result) {
+    JsonDocument resDoc(&netArena);
+    uint32_t p0 = micros();
+    parseResponse(resDoc, logClient, response);
+    NetTiming timing = logClient.timing();
+    timing.set(STAGE_PARSE, micros() - p0);
+    logNet.record(timing);
+    uint32_t next = resDoc["nextPollMs"] | 0;
+    serverPollMs = next ? constrain(next, (uint32_t)POLL_MIN_MS, (uint32_t)POLL_MAX_MS) : 0;
+    uint32_t retry = resDoc["retryAfter"] | 0;
+    if (retry) holdPoll(retry);
+    updateCommand(resDoc["command"] | "AUTO", resDoc["position"] | 100, resDoc["version"] | (uint64_t)0, false);
+    fillResult(result);
+}
+
+// Sérialise `doc` dans l'arène, au format négocié avec le backend, et le poste ;
+// le corps ne vit que le temps de la requête.
+int postDoc(const char* url, JsonDocument& doc, char* response, size_t size) {
+    int code;
+    bool pack;
+    do {
+        pack = logClient.msgpack();
+        size_t len = pack ? measureMsgPack(doc) : measureJson(doc);
+        char* body = (char*)netArena.allocate(len + 1);
+        if (!body) return HTTPC_ERROR_TOO_LESS_RAM;
+        if (pack) serializeMsgPack(doc, body, len);
+        else serializeJson(doc, body, len + 1);
+        txStats.bytes += len;
+        code = logClient.post(url, body, len, response, size);
+        netArena.deallocate(body);
+        // MessagePack refusé explicitement : renvoyé en JSON. Une réponse 2xx
+        // en JSON vaut réception, le document ne repart pas.
+    } while (pack && (code == 415 || code == 406));
+    if (!doc["tx"].isNull()) {
+        // Compteurs joints : perdus avec l'envoi, ils repartent au suivant
+        if (code != 200) statsDue = true;
+        else if (!doc["boot"].isNull()) bootPending = false;
+    }
+    if (code == 200 && !bootStats.telemetryMs) {
+        bootStats.telemetryMs = millis();
+        statsDue = true; // le bloc boot part avec l'envoi suivant
+        Serial.printf("Première télémétrie %u ms après le démarrage (WiFi à %u ms)\n",
+                      (unsigned)bootStats.telemetryMs, (unsigned)bootStats.wifiMs);
+    }
+    return code;
+}
+
+// Mode lots : l'échantillon attend dans l'anneau PSRAM et part avec les autres
+// tous les `size` échantillons, toutes les batchPeriodMs ou dès que la fenêtre
+// change d'état. L'ordre revient dans la réponse du lot ; sans lot à envoyer,
+// il vient du canal push, ou à défaut d'un GET toutes les batchPeriodMs.
+bool batchTick(const NetJob& job, uint32_t ts, bool due, NetResult& result, uint32_t size) {
+    if (due && weatherKnown) pendingSamples.push(ts, lastTemp, lastAQI, job.isOpen);
+    char response[RESPONSE_SIZE];
+    // Pas de lot vide : sans échantillon retenu, le poll ne fait que relire l'ordre
+    bool flush = pendingSamples.count() >= size ||
+                 (pendingSamples.count() > 0 &&
+                  (job.isOpen != lastBatchOpen || millis() - lastBatchExchange >= batchPeriodMs));
+    if (!flush) {
+        if (pushAlive || millis() - lastBatchExchange < batchPeriodMs) {
+            fillResult(result);
+            return true;
+        }
+        lastBatchExchange = millis();
+        if (logClient.get(API_COMMAND_URL, response, sizeof(response)) != 200) return false;
+        readCommand(response, result);
+        return true;
+    }
+
+    JsonDocument doc(&netArena);
+    JsonArray samples = doc["samples"].to<JsonArray>();
+    for (size_t i = 0; i < pendingSamples.count(); i++) addSample(samples, pendingSamples.at(i));
+    addStats(doc);
+    lastBatchExchange = millis();
+    int code = postDoc(API_BATCH_URL, doc, response, sizeof(response));
+    if (code != 200) {
+        // Backend injoignable : le lot rejoint la file en flash
+        for (size_t i = 0; i < pendingSamples.count(); i++) {
+            const TelemetryRecord& r = pendingSamples.at(i);
+            if (r.ts) telemetry.push(r.ts, r.temp10 / 10.0f, r.aqi, r.isOpen);
         }
-        http.end();
+        pendingSamples.clear();
+        return false;
+    }
+    pendingSamples.clear();
+    lastBatchOpen = job.isOpen;
+    readCommand(response, result);
+    return true;
+}
+
+// Délai avant la prochaine récupération météo, après un succès ou une erreur.
+uint32_t weatherRefreshS(bool fetched) {
+    if (!fetched) {
+        weatherFailures = min(weatherFailures + 1, 8);
+        return netJitter.backoff(WEATHER_MIN_S, WEATHER_RETRY_MAX_S, weatherFailures, WEATHER_MIN_S);
+    }
+    weatherFailures = 0;
+    uint32_t now = epochNow();
+    uint32_t spread = pollJitterPct ? WEATHER_SPREAD_S : 0;
+    if (!now || !weatherUpstream || !weatherInterval) return WEATHER_MIN_S + netJitter.below(spread / 4);
+    // Même échéance pour toute la flotte : chaque appareil la décale de son retard propre
+    uint32_t due = weatherUpstream + weatherInterval + WEATHER_LAG_S + netJitter.offset(spread);
+    if (due <= now) {
+        // Service en retard sur sa cadence : relu dans 1, 2, 4 puis 8 min au plus
+        weatherStale = min(weatherStale + 1, 4);
+        return netJitter.backoff(WEATHER_MIN_S, WEATHER_MIN_S << 3, weatherStale, WEATHER_MIN_S);
+    }
+    weatherStale = 0;
+    return constrain(due - now, (uint32_t)WEATHER_MIN_S, (uint32_t)WEATHER_MAX_S);
+}
+
+// Exécuté par la tâche réseau. Renvoie false si aucun ordre n'a été reçu.
+bool checkSystem(const NetJob& job, NetResult& result) {
+    netArena.reset();
+    uint32_t ts = epochNow();
+    if(WiFi.status() != WL_CONNECTED) {
+        // Box en redémarrage : l'échantillon attend en flash (rien à garder si le WiFi n'est pas
+        // configuré, ni avant la première météo et l'heure NTP)
+        if (!job.weatherOnly && wifiConfigured && sampleStorable(ts) && sampleDue(job.isOpen))
+            telemetry.push(ts, lastTemp, lastAQI, job.isOpen);
+        return false;
+    }
+
+    // 1. Récupération Météo (à l'échéance du rafraîchissement, ou tout de suite
+    // si les coordonnées ont changé ou si une règle lit un champ pas encore
+    // demandé). Le timer météo réveille loop() à l'échéance suivante, même si
+    // le poll est ralenti ou suspendu.
+    if (job.weatherOnly || millis() - lastWeatherCheck >= weatherDelayS * 1000UL || lastWeatherCheck == 0 ||
+        job.coordsGen != weatherCoordsGen || (rulesUses & ~weatherUses)) {
+        bool fetched = fetchWeather();
+        if (fetched) weatherCoordsGen = job.coordsGen;
+        weatherDelayS = weatherRefreshS(fetched);
+        weatherClient.release(weatherDelayS * 1000UL);
         lastWeatherCheck = millis();
+        xTimerChangePeriod(weatherTimer, pdMS_TO_TICKS(max(weatherDelayS, (uint32_t)1) * 1000UL), 0);
+    }
+    if (job.weatherOnly) {
+        // Nouvelle météo pour le mode AUTO, avec le dernier ordre connu
+        fillResult(result);
+        return true;
     }
 
-    // 2. Envoi Log au Serveur ET Lecture de l'Ordre
-    HTTPClient httpLog;
-    httpLog.begin(API_URL); 
-    httpLog.addHeader("Content-Type", "application/json");
-    
-    String jsonStr;
-    JsonDocument logDoc;
+    // Lots si configurés ou si le canal push porte les ordres ; un reste de lot
+    // part au poll suivant quand le push tombe.
+    bool due = sampleDue(job.isOpen);
+    uint32_t size = batchSize > 1 ? batchSize : (pushAlive ? PUSH_BATCH : 0);
+    if (size > 1 || pendingSamples.count() > 0) return batchTick(job, ts, due, result, max(size, (uint32_t)1));
+
+    // 2. Envoi Log au Serveur ET Lecture de l'Ordre (connexion keep-alive partagée)
+    char response[RESPONSE_SIZE];
+    if (!due) {
+        // Rien de neuf à dire : simple lecture de l'ordre
+        if (logClient.get(API_COMMAND_URL, response, sizeof(response)) != 200) return false;
+        readCommand(response, result);
+        return true;
+    }
+    JsonDocument logDoc(&netArena);
     logDoc["temp"] = lastTemp;
     logDoc["aqi"] = lastAQI;
-    logDoc["isOpen"] = isOpen;
-    serializeJson(logDoc, jsonStr);
-    
-    int httpResponseCode = httpLog.POST(jsonStr);
-
-    if (httpResponseCode > 0) {
-        String response = httpLog.getString();
-        JsonDocument resDoc;
-        deserializeJson(resDoc, response);
-        
-        // On lit l'ordre du serveur : "AUTO", "OPEN" ou "CLOSE"
-        String command = resDoc["command"].as<String>();
-        
-        Serial.print("Météo: " + String(lastTemp) + "C | Ordre Serveur: " + command);
-
-        if (command == "OPEN") {
-            Serial.println(" -> Force OUVERTURE");
-            setWindow(true);
-        } else if (command == "CLOSE") {
-             Serial.println(" -> Force FERMETURE");
-            setWindow(false);
-        } else {
-            // Mode AUTO : On décide selon la météo stockée
-            Serial.println(" -> Mode AUTO");
-            if (lastTemp > 30.0 || lastAQI > 50) setWindow(false);
-            else setWindow(true);
+    logDoc["isOpen"] = job.isOpen;
+    logDoc["opening"] = job.opening;
+    if (ts) logDoc["ts"] = ts;
+    addStats(logDoc);
+
+    int httpResponseCode = postDoc(API_URL, logDoc, response, sizeof(response));
+    if (httpResponseCode != 200) {
+        // Injoignable, surchargé (429/503, Retry-After) ou en erreur : le corps
+        // n'est pas un ordre, et l'échantillon déjà compté comme envoyé attend en flash
+        if (sampleStorable(ts)) telemetry.push(ts, lastTemp, lastAQI, job.isOpen);
+        return false;
+    }
+
+    readCommand(response, result);
+    return true;
+}
+
+// Renvoie un lot d'échantillons stockés pendant une coupure, une fois le backend revenu.
+void drainBacklog() {
+    TelemetryRecord batch[TELEMETRY_BATCH];
+    size_t n = telemetry.peek(batch, TELEMETRY_BATCH);
+    if (n == 0) return;
+
+    netArena.reset();
+    JsonDocument doc(&netArena);
+    JsonArray samples = doc["samples"].to<JsonArray>();
+    for (size_t i = 0; i < n; i++) addSample(samples, batch[i]);
+    char response[RESPONSE_SIZE];
+    int code = postDoc(API_BATCH_URL, doc, response, sizeof(response));
+    if (code != 200) return; // réessayé au prochain poll réussi
+    telemetry.ack(batch[n - 1].seq);
+    Serial.printf("telemetry: %u échantillons renvoyés, %u en attente\n", (unsigned)n, (unsigned)telemetry.pending());
+}
+
+// Décision du mode AUTO sur la météo de `in` : complète l'heure locale et
+// évalue les règles en service.
+RuleAction decideAuto(RuleInputs& in, int* rule) {
+    in.v[RULE_HOUR] = NAN;
+    time_t now = epochNow();
+    struct tm local;
+    if (now && localOffsetKnown) {
+        now += localOffsetS;
+        if (gmtime_r(&now, &local)) in.v[RULE_HOUR] = local.tm_hour + local.tm_min / 60.0f;
+    }
+
+    xSemaphoreTake(rulesLock, portMAX_DELAY);
+    RuleAction action = rules.evaluate(in, rule);
+    xSemaphoreGive(rulesLock);
+    return action;
+}
+
+// Exécuté dans loop() : applique l'ordre du serveur, ou décide selon la météo en AUTO.
+void applyCommand(const NetResult& result) {
+    Serial.printf("Météo: %.2fC | Ordre Serveur: %s", result.temp, result.command);
+
+    if (strcmp(result.command, "OPEN") == 0) {
+        Serial.printf(" -> Force OUVERTURE (%u %%)\n", (unsigned)result.position);
+        setOpening(result.position);
+        lastMoveDir = 0; // ordre manuel : au retour en AUTO, pas de durée minimale à respecter
+    } else if (strcmp(result.command, "CLOSE") == 0) {
+         Serial.println(" -> Force FERMETURE");
+        setWindow(false);
+        lastMoveDir = 0;
+    } else {
+        // Mode AUTO : les règles décident selon la météo stockée et l'heure locale
+        RuleInputs in;
+        in.v[RULE_TEMP] = result.temp;
+        in.v[RULE_AQI] = result.aqi;
+        in.v[RULE_WIND] = result.wind;
+        in.v[RULE_RAIN] = result.rain;
+        in.v[RULE_HUMIDITY] = result.humidity;
+        int rule;
+        RuleAction action = decideAuto(in, &rule);
+        Serial.printf(" -> Mode AUTO (règle %d : %s)\n", rule, RuleSet::actionName(action));
+        uint8_t target = action == RULE_OPEN ? 100 : 0;
+        if (action == RULE_HOLD || target == opening) {
+            autoHeld = false;
+        } else if (autoMayMove(target)) {
+            autoHeld = false;
+            lastMoveDir = target > opening ? 1 : -1;
+            lastMoveAt = millis();
+            setOpening(target);
+        } else if (!autoHeld) {
+            // Compté une fois par décision retardée, pas à chaque poll
+            autoHeld = true;
+            actStats.held++;
+            Serial.printf("AUTO: %s retardé (durée minimale)\n", RuleSet::actionName(action));
+        }
+    }
+}
+
+// Traite le poll en attente, en bloquant au plus `wait` ticks.
+void netService(TickType_t wait) {
+    NetJob job;
+    if (xQueueReceive(netJobs, &job, wait) != pdTRUE) return;
+    PowerHold awake(power);
+    NetResult result;
+    bool received = checkSystem(job, result);
+    if (job.weatherOnly) {
+        if (received) postResult(result);
+        return;
+    }
+    uint32_t retry = logClient.takeRetryAfter();
+    if (retry) holdPoll(retry);
+    if (!received) {
+        // Backend en échec (pas le WiFi : rien n'est parti) : recul en full jitter
+        if (WiFi.status() == WL_CONNECTED) {
+            pollFailures = min(pollFailures + 1, 16);
+            uint32_t period = serverPollMs ? serverPollMs : pollPeriodMs;
+            pollHoldMs = max((uint32_t)pollHoldMs, netJitter.backoff(period, POLL_BACKOFF_MAX_MS, pollFailures));
+        }
+        return;
+    }
+    pollFailures = 0;
+    // Opérationnel pour cette configuration si la météo vient de ses coordonnées
+    if (job.coordsGen == weatherCoordsGen) result.configGen = job.configGen;
+    postResult(result);
+    // Après l'ordre, pour ne pas le retarder : un lot de rattrapage par poll
+    if (telemetry.pending() > 0) drainBacklog();
+}
+
+void netTask(void *) {
+    for (;;) netService(portMAX_DELAY);
+}
+
+// Canal push : le backend ne répond au long-poll que lorsque l'ordre change (ou
+// au bout de PUSH_WAIT_S). L'ordre part aussitôt vers loop(). En cas d'échec, le
+// poll reprend la main et le canal retente avec un délai croissant, tiré au
+// hasard pour que la flotte ne revienne pas d'un bloc au redémarrage du backend.
+void pushTask(void *) {
+    pushClient.begin(API_COMMAND_URL, (PUSH_WAIT_S + 5) * 1000);
+    pushArena.begin(1024);
+    uint8_t failures = 0;
+    bool associated = false;
+    for (;;) {
+        if (WiFi.status() != WL_CONNECTED) {
+            pushAlive = false;
+            associated = false;
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+        // Comme le premier poll : connexion étalée sur une période après l'association
+        if (!associated) {
+            associated = true;
+            if (pollJitterPct) vTaskDelay(pdMS_TO_TICKS(1 + pushJitter.below(pollPeriodMs)));
+        }
+        char url[160];
+        snprintf(url, sizeof(url), "%s?since=%llu&wait=%d", API_COMMAND_URL,
+                 (unsigned long long)currentCommand().version, PUSH_WAIT_S);
+        char response[RESPONSE_SIZE];
+        pushArena.reset();
+        JsonDocument doc(&pushArena);
+        int code = pushClient.get(url, response, sizeof(response));
+        if (code != 200 || parseResponse(doc, pushClient, response) || !doc["version"].is<uint64_t>()) {
+            // Backend injoignable, surchargé (Retry-After) ou trop ancien pour le long-poll
+            pushAlive = false;
+            uint32_t retryMs = min(pushClient.takeRetryAfter(), (uint32_t)RETRY_AFTER_MAX_S) * 1000;
+            failures = min(failures + 1, 16);
+            vTaskDelay(pdMS_TO_TICKS(max(pushJitter.backoff(1000, PUSH_BACKOFF_MAX_MS, failures, 500), retryMs)));
+            continue;
+        }
+        pushAlive = true;
+        failures = 0;
+        if (updateCommand(doc["command"] | "AUTO", doc["position"] | 100, doc["version"].as<uint64_t>(), true)) {
+            NetResult result;
+            fillResult(result);
+            postResult(result);
         }
     }
-    httpLog.end();
+}
+
+// Attente du tour de poll en cours : période (dictée ou pollMs) étirée de
+// pollSkew, ou délai de démarrage ; une pause demandée plus longue l'emporte.
+// Recalculée à chaque passage : un nextPollMs reçu s'applique au tour en cours.
+unsigned long pollWait() {
+    unsigned long period = serverPollMs ? serverPollMs : pollPeriodMs;
+    unsigned long wait = pollStartMs ? pollStartMs : period + (long)period * pollSkew / 1000;
+    return max(wait, (unsigned long)pollHoldMs);
+}
+
+// Tour de poll : instantané de l'état pour la tâche réseau, tirage de
+// l'étirement du tour suivant.
+void startPoll() {
+    NetJob job = { isOpen, opening, configGen, coordsGen, false };
+    pollHoldMs = 0; // avant l'envoi : la réponse peut demander une nouvelle pause
+    pollStartMs = 0;
+    int16_t spread = pollJitterPct * 10;
+    pollSkew = (int16_t)pollJitter.below(2 * spread + 1) - spread;
+    xQueueOverwrite(netJobs, &job);
+    lastPoll = millis();
+    pollNow = false;
+    if (!netThreaded) netService(0);
+}
+
+// Réarme le timer du poll sur le reste du tour en cours. Appelé après chaque
+// événement : une pause ou un nextPollMs reçu entre-temps déplace l'échéance.
+void schedulePoll() {
+    unsigned long elapsed = millis() - lastPoll;
+    unsigned long wait = pollWait();
+    xTimerChangePeriod(pollTimer, pdMS_TO_TICKS(elapsed < wait ? wait - elapsed : 1), 0);
+}
+
+// Échéance météo : relecture par la tâche réseau, sauf si un poll en attente
+// va s'en charger.
+void requestWeather() {
+    if (uxQueueMessagesWaiting(netJobs) > 0) return;
+    NetJob job = { isOpen, opening, configGen, coordsGen, true };
+    xQueueOverwrite(netJobs, &job);
+    if (!netThreaded) netService(0);
+}
+
+void applyResult(const NetResult& result) {
+    if (provisioning && result.configGen == configGen) {
+        provisionStats.lastMs = millis() - provisionAt;
+        provisioning = false;
+        Serial.printf("Opérationnel %u ms après la configuration BLE\n", (unsigned)provisionStats.lastMs);
+    }
+    applyCommand(result);
 }
 
 void setup() {
@@ -124,26 +1143,143 @@ void setup() {
     wifi_pass = preferences.getString("pass", "");
     latitude = preferences.getFloat("lat", 45.18);
     longitude = preferences.getFloat("lon", 5.72);
+    uint32_t backlog = preferences.getUInt("backlog", TELEMETRY_BACKLOG);
+    batchSize = min(preferences.getUInt("batch", 0), (uint32_t)SAMPLE_RING_SIZE);
+    batchPeriodMs = preferences.getUInt("batchT", 30) * 1000UL;
+    deadbandTemp = preferences.getFloat("dbTemp", 0.2);
+    deadbandAqi = preferences.getInt("dbAqi", 2);
+    heartbeatMs = preferences.getUInt("heartbeat", 300) * 1000UL;
+    pollPeriodMs = max(preferences.getUInt("pollMs", 2000), (uint32_t)100);
+    pollJitterPct = min(preferences.getUInt("jitter", 10), (uint32_t)50);
+    // Économie d'énergie : 0 éveillé, 1 modem-sleep, 2 light-sleep automatique ;
+    // retard admis sur un ordre poussé par le backend
+    uint8_t powerMode = preferences.getUChar("power", PowerManager::POWER_MODEM);
+    uint32_t latencyMs = preferences.getUInt("latencyMs", 300);
+    // Profil de mouvement : course complète en ~1,5 s par défaut
+    float moveSpeed = preferences.getFloat("moveSpeed", 100);
+    float moveAccel = preferences.getFloat("moveAccel", 200);
+    hysteresis[RULE_TEMP] = preferences.getFloat("hystTemp", 1.0);
+    hysteresis[RULE_AQI] = preferences.getFloat("hystAqi", 5);
+    hysteresis[RULE_WIND] = preferences.getFloat("hystWind", 5);
+    holdOpenMs = preferences.getUInt("holdOpen", 120) * 1000UL;
+    holdClosedMs = preferences.getUInt("holdClosed", 600) * 1000UL;
+    String savedRules = preferences.getString("rules", RuleSet::DEFAULT_RULES);
+    fastIp = preferences.getBool("fastIp", false);
+    if (preferences.getBytes("wifiCache", &wifiCache, sizeof(wifiCache)) != sizeof(wifiCache)) wifiCache = {};
+    wifiCache.ssid[sizeof(wifiCache.ssid) - 1] = 0;
+    preferences.end();
+    preferences.begin("config", false);
+    bootStats = {};
+    bootPending = true;
+    bootStats.count = preferences.getUInt("boots", 0) + 1;
+    preferences.putUInt("boots", bootStats.count);
     preferences.end();
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    pollJitter.begin(mac, 1);
+    netJitter.begin(mac, 2);
+    pushJitter.begin(mac, 3);
+    power.begin(powerMode, latencyMs);
+    // Événements de loop() et timers qui le réveillent, avant la première association
+    if (!loopEvents) {
+        loopEvents = xQueueCreate(LOOP_EVENTS, sizeof(LoopEvent));
+        pollTimer = xTimerCreate("poll", 1, pdFALSE, (void*)EVENT_POLL, onTimer);
+        weatherTimer = xTimerCreate("weather", 1, pdFALSE, (void*)EVENT_WEATHER, onTimer);
+        wifiTimer = xTimerCreate("wifi", pdMS_TO_TICKS(WIFI_CHECK_MS), pdTRUE, (void*)EVENT_WIFI, onTimer);
+    }
+    xQueueReset(loopEvents);
+    // L'association se fait pendant le reste de setup() (flash, BLE)
+    if (wifi_ssid != "") wifiConnect();
+    wifiConfigured = wifi_ssid != "";
+    if (!rulesLock) rulesLock = xSemaphoreCreateMutex();
+    RuleSet loaded;
+    char rulesError[48];
+    if (!loaded.compile(savedRules.c_str(), rulesError, sizeof(rulesError))) {
+        Serial.printf("Règles enregistrées invalides (%s) : règles par défaut\n", rulesError);
+        savedRules = RuleSet::DEFAULT_RULES;
+        loaded.compile(RuleSet::DEFAULT_RULES);
+    }
+    installRules(loaded, savedRules);
+    windowMotion.setPower(&power);
+    if (!windowMotion.begin(windowServo, WINDOW_CLOSED_US, WINDOW_OPEN_US, moveSpeed, moveAccel)) {
+        Serial.println("Timer du servo indisponible");
+    }
+    telemetry.begin("/tlm", backlog);
+    if (!pendingSamples.begin(SAMPLE_RING_SIZE)) batchSize = 0;
+    // Arène du poll taillée pour le plus gros document envoyé ; sans la place, une arène
+    // minimale et le débordement sur le tas pour les gros lots
+    uint32_t largest = max(max(batchSize, (uint32_t)PUSH_BATCH), (uint32_t)TELEMETRY_BATCH);
+    if (!netArena.begin(NET_ARENA_BASE + NET_ARENA_PER_SAMPLE * largest)) netArena.begin(NET_ARENA_BASE);
+    if (batchSize > 1) Serial.printf("Télémétrie par lots de %u (%lu s max), anneau en %s\n", (unsigned)batchSize, batchPeriodMs / 1000, pendingSamples.inPsram() ? "PSRAM" : "RAM interne");
 
+    if (!configEvents) configEvents = xQueueCreate(1, sizeof(ConfigEvent));
     BLEDevice::init("ESP32_SmartWindow");
     BLEServer *pServer = BLEDevice::createServer();
     BLEService *pService = pServer->createService(SERVICE_UUID);
     BLECharacteristic *pChar = pService->createCharacteristic(CHAR_CONFIG_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE);
     pChar->setCallbacks(new ConfigCallbacks());
+    BLECharacteristic *pRules = pService->createCharacteristic(CHAR_RULES_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE);
+    pRules->setValue(rulesText.c_str());
+    pRules->setCallbacks(new RulesCallbacks());
     pService->start();
     BLEDevice::getAdvertising()->addServiceUUID(SERVICE_UUID);
     BLEDevice::getAdvertising()->start();
 
-    if(wifi_ssid != "") WiFi.begin(wifi_ssid.c_str(), wifi_pass.c_str());
+    logClient.begin(API_URL);
+    weatherClient.begin("api.open-meteo.com");
+    configTime(0, 0, "pool.ntp.org"); // horodatage des échantillons stockés en coupure
+
+    for (const WeatherField& field : WEATHER_FIELDS) weatherFilter["current"][field.name] = true;
+    // Horodatage de la valeur, pour caler le rafraîchissement
+    weatherFilter["current"]["time"] = true;
+    weatherFilter["current"]["interval"] = true;
+    weatherFilter["utc_offset_seconds"] = true;
+
+    if (!commandLock) commandLock = xSemaphoreCreateMutex();
+    // Boîte aux lettres d'une place : un poll pas encore traité est remplacé par l'état le plus récent.
+    // File et tâche réseau créées une seule fois, comme la tâche push : un seul consommateur de netArena
+    if (!netJobs) netJobs = xQueueCreate(1, sizeof(NetJob));
+    if (!netTaskHandle) xTaskCreatePinnedToCore(netTask, "net", 8192, nullptr, 1, &netTaskHandle, 0);
+    netThreaded = netTaskHandle != nullptr;
+    if (!netThreaded) Serial.println("Tâche réseau indisponible : réseau traité dans loop()");
+    // Une seule tâche push pour toute la vie du programme (setup() peut être rejoué sur l'hôte)
+    if (netThreaded && pendingSamples.capacity() > 0 && !pushTaskHandle &&
+        xTaskCreatePinnedToCore(pushTask, "push", 6144, nullptr, 1, &pushTaskHandle, 0) != pdPASS) {
+        Serial.println("Canal push indisponible : ordres relus à chaque poll");
+    }
+    schedulePoll();
 }
 
 void loop() {
-    // Vérification rapide (toutes les 2 secondes) pour être réactif aux boutons
-    static unsigned long lastCheck = 0;
-    if (millis() - lastCheck > 2000) { 
-        checkSystem();
-        lastCheck = millis();
+    // Rien à faire entre deux événements : la tâche dort jusqu'au suivant
+    LoopEvent event;
+    bool woken = xQueueReceive(loopEvents, &event, portMAX_DELAY) == pdTRUE;
+    PowerHold awake(power);
+    // Écritures BLE, même si leur événement n'a pas trouvé de place dans la file
+    ConfigEvent cfg;
+    if (xQueueReceive(configEvents, &cfg, 0) == pdTRUE) applyConfig(cfg);
+    if (rulesUnsaved) {
+        rulesUnsaved = false;
+        saveRules();
+    }
+    if (woken) {
+        switch (event.type) {
+        case EVENT_CONFIG:
+        case EVENT_RULES:
+            break; // déjà relues ci-dessus
+        case EVENT_WIFI:
+            wifiService();
+            break;
+        case EVENT_WEATHER:
+            requestWeather();
+            break;
+        case EVENT_COMMAND:
+            applyResult(event.result);
+            break;
+        case EVENT_POLL:
+            break; // échéance vérifiée ci-dessous
+        }
     }
-    delay(100);
+    if (pollNow || millis() - lastPoll >= pollWait()) startPoll();
+    schedulePoll();
 }
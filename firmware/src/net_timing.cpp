@@ -0,0 +1,53 @@
+#include "net_timing.h"
+
+void LatencyHistogram::add(uint32_t us) {
+    uint8_t bucket = 31 - __builtin_clz(us | 1);
+    if (bucket >= BUCKETS) bucket = BUCKETS - 1;
+    _counts[bucket]++;
+    if (++_total < WINDOW) return;
+    _total = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        _counts[i] >>= 1;
+        _total += _counts[i];
+    }
+}
+
+uint32_t LatencyHistogram::quantile(float q) const {
+    if (_total == 0) return 0;
+    float target = q * _total;
+    float seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        if (_counts[i] == 0) continue;
+        if (seen + _counts[i] >= target) {
+            // Seau [2^i, 2^(i+1)) (le premier commence à 0), rempli uniformément
+            float lo = i ? (float)(1UL << i) : 0.0f;
+            float hi = (float)(1UL << (i + 1));
+            return (uint32_t)(lo + (hi - lo) * (target - seen) / _counts[i]);
+        }
+        seen += _counts[i];
+    }
+    return 1UL << BUCKETS;
+}
+
+void NetStats::record(const NetTiming& timing) {
+    _exchanges++;
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        if (timing.mask & (1 << i)) _stages[i].add(timing.us[i]);
+    }
+}
+
+void NetStats::summary(JsonObject out) const {
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& h = _stages[i];
+        if (h.count() == 0) continue;
+        JsonArray stage = out[stageName((NetStage)i)].to<JsonArray>();
+        stage.add(h.count());
+        stage.add(h.quantile(0.5f));
+        stage.add(h.quantile(0.9f));
+    }
+}
+
+const char* NetStats::stageName(NetStage stage) {
+    static const char* const names[STAGE_COUNT] = { "dns", "connect", "tls", "send", "wait", "body", "parse" };
+    return stage < STAGE_COUNT ? names[stage] : "?";
+}
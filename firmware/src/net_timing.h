@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Étapes d'un échange HTTP. `tls` : connexion HTTPS, TCP compris (le client
+// sécurisé du core ne sépare pas les deux) ; `connect` : connexion TCP en clair.
+// DNS et connexion n'existent que sur une connexion neuve. `wait` : de la fin
+// de l'envoi au premier octet de la réponse ; `body` : du premier octet à la
+// fin du corps (en-têtes compris) ; `parse` : désérialisation (JSON ou MessagePack). Le
+// premier octet est vu au rythme où HTTPClient interroge le socket.
+enum NetStage : uint8_t { STAGE_DNS, STAGE_CONNECT, STAGE_TLS, STAGE_SEND, STAGE_WAIT, STAGE_BODY, STAGE_PARSE, STAGE_COUNT };
+
+// Durées (µs) des étapes du dernier échange.
+struct NetTiming {
+    uint32_t us[STAGE_COUNT];
+    uint8_t mask; // étapes mesurées (1 << NetStage)
+
+    void clear() { *this = {}; }
+    void set(NetStage stage, uint32_t value) {
+        us[stage] = value;
+        mask |= 1 << stage;
+    }
+};
+
+// Histogramme glissant de durées en µs, un seau par puissance de deux (de 1 µs
+// à 16 s). Tous les WINDOW échantillons les comptes sont divisés par deux : les
+// quantiles suivent les quelques centaines de derniers échanges.
+class LatencyHistogram {
+public:
+    static const uint8_t BUCKETS = 24;
+    static const uint16_t WINDOW = 256;
+
+    void add(uint32_t us);
+    uint32_t count() const { return _total; }
+    // Quantile estimé (interpolé dans le seau), 0 si vide.
+    uint32_t quantile(float q) const;
+
+private:
+    uint16_t _counts[BUCKETS] = {};
+    uint16_t _total = 0;
+};
+
+// Histogrammes par étape d'un type d'échange (log, météo).
+class NetStats {
+public:
+    void record(const NetTiming& timing);
+    uint32_t exchanges() const { return _exchanges; }
+    // {"dns": [n, p50, p90], ...} en µs, étapes mesurées seulement.
+    void summary(JsonObject out) const;
+
+    static const char* stageName(NetStage stage);
+
+private:
+    LatencyHistogram _stages[STAGE_COUNT];
+    uint32_t _exchanges = 0;
+};
+
+// Client chronométré : marque le début et la fin de l'envoi (écritures de
+// HTTPClient) et l'arrivée du premier octet de la réponse (premier available()
+// non nul après l'envoi), sans toucher au chemin de HTTPClient.
+template <class Base>
+class TimedClient : public Base {
+public:
+    // À appeler avant chaque requête.
+    void arm() { _sendStart = _sendEnd = _firstByte = 0; }
+    uint32_t sendStart() const { return _sendStart; }
+    uint32_t sendEnd() const { return _sendEnd; }
+    uint32_t firstByte() const { return _firstByte; }
+
+    using Base::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override {
+        if (!_sendStart) _sendStart = stamp();
+        size_t n = Base::write(buf, size);
+        _sendEnd = stamp();
+        return n;
+    }
+    int available() override {
+        int n = Base::available();
+        if (n > 0 && _sendEnd && !_firstByte) _firstByte = stamp();
+        return n;
+    }
+
+private:
+    static uint32_t stamp() {
+        uint32_t now = micros();
+        return now ? now : 1; // 0 : pas encore marqué
+    }
+
+    uint32_t _sendStart = 0;
+    uint32_t _sendEnd = 0;
+    uint32_t _firstByte = 0;
+};
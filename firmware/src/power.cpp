@@ -0,0 +1,76 @@
+#include "power.h"
+#include <esp_timer.h>
+
+void PowerManager::begin(uint8_t mode, uint32_t latencyMs) {
+    if (!_mutex) _mutex = xSemaphoreCreateMutex();
+    _listen = min(latencyMs * 1000 / BEACON_US, (uint32_t)LISTEN_MAX);
+    _mode = min(mode, (uint8_t)POWER_LIGHT);
+    // Borne plus courte qu'un beacon : la radio reste à l'écoute
+    if (_listen == 0) _mode = POWER_AWAKE;
+    if (_mode == POWER_LIGHT) {
+        esp_pm_config_esp32_t pm = {};
+        pm.max_freq_mhz = 240;
+        pm.min_freq_mhz = 80; // plancher de l'APB tant que le WiFi tourne
+        pm.light_sleep_enable = true;
+        if (!_lock && esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "awake", &_lock) != ESP_OK) _lock = nullptr;
+        if (!_lock || esp_pm_configure(&pm) != ESP_OK) {
+            // Core compilé sans CONFIG_PM_ENABLE ou sans tickless idle
+            Serial.println("Light-sleep indisponible : modem-sleep seul");
+            _mode = POWER_MODEM;
+        }
+    }
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _startUs = esp_timer_get_time();
+    _heldSince = _startUs;
+    _awakeUs = 0;
+    xSemaphoreGive(_mutex);
+}
+
+void PowerManager::applyListen() {
+    if (_mode == POWER_AWAKE) return;
+    // Réveil compté en beacons, pas en DTIM : la borne tient quel que soit le point d'accès
+    wifi_config_t conf;
+    if (esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK && conf.sta.listen_interval != _listen) {
+        conf.sta.listen_interval = _listen;
+        esp_wifi_set_config(WIFI_IF_STA, &conf);
+    }
+}
+
+void PowerManager::applyWifi() {
+    if (_mode == POWER_AWAKE) {
+        // Refusé par l'IDF tant que le BLE tourne (coexistence) : la radio garde alors son modem-sleep par défaut
+        if (esp_wifi_set_ps(WIFI_PS_NONE) != ESP_OK) Serial.println("Radio : modem-sleep imposé par le BLE");
+        return;
+    }
+    esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+}
+
+void PowerManager::hold() {
+    if (!_mutex) return;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_holds++ == 0) {
+        _heldSince = esp_timer_get_time();
+        if (_mode == POWER_LIGHT) esp_pm_lock_acquire(_lock);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+void PowerManager::release() {
+    if (!_mutex) return;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (_holds > 0 && --_holds == 0) {
+        _awakeUs += esp_timer_get_time() - _heldSince;
+        if (_mode == POWER_LIGHT) esp_pm_lock_release(_lock);
+    }
+    xSemaphoreGive(_mutex);
+}
+
+uint16_t PowerManager::awakePermille() {
+    if (!_mutex || _mode != POWER_LIGHT) return 1000;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    int64_t awake = _awakeUs + (_holds ? now - _heldSince : 0);
+    int64_t total = now - _startUs;
+    xSemaphoreGive(_mutex);
+    return total > 0 ? (uint16_t)min<int64_t>(awake * 1000 / total, 1000) : 1000;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Économie d'énergie entre deux événements. La radio passe en modem-sleep :
+// elle ne se réveille que tous les `listen` beacons (102,4 ms) pour relever
+// les trames gardées par le point d'accès, ce qui retarde d'autant un ordre
+// poussé sans qu'on l'attende ; `listen` est choisi sous la borne de latence.
+// En light-sleep automatique, le CPU s'endort aussi dès qu'aucune tâche n'a de
+// travail, sauf pendant un hold() (événement en cours, échange réseau, course
+// du servo) : le temps passé sous hold() donne alors la part de temps éveillé.
+class PowerManager {
+public:
+    enum Mode : uint8_t { POWER_AWAKE, POWER_MODEM, POWER_LIGHT };
+    static const uint32_t BEACON_US = 102400;
+    static const uint8_t LISTEN_MAX = 10; // au-delà, le point d'accès peut lâcher les trames gardées
+
+    // `mode` demandé ; `latencyMs` : retard admis sur une trame non sollicitée.
+    // Sans la gestion d'énergie de l'IDF (light-sleep refusé), repli sur POWER_MODEM.
+    void begin(uint8_t mode, uint32_t latencyMs);
+    // Entre WiFi.begin(..., false) et esp_wifi_connect() : l'intervalle
+    // d'écoute est annoncé dans la requête d'association.
+    void applyListen();
+    // Après chaque association : mode de la radio.
+    void applyWifi();
+
+    // Imbriquables, depuis n'importe quelle tâche.
+    void hold();
+    void release();
+
+    uint8_t mode() const { return _mode; }
+    uint8_t listen() const { return _listen; } // 0 : radio toujours à l'écoute
+    // Part du temps où le CPU est resté éveillé depuis begin(), en ‰ : 1000
+    // hors POWER_LIGHT, où il ne dort jamais.
+    uint16_t awakePermille();
+
+private:
+    uint8_t _mode = POWER_AWAKE;
+    uint8_t _listen = 0;
+    esp_pm_lock_handle_t _lock = nullptr;
+    SemaphoreHandle_t _mutex = nullptr;
+    uint16_t _holds = 0;
+    int64_t _startUs = 0;
+    int64_t _heldSince = 0;
+    int64_t _awakeUs = 0;
+};
+
+// hold() pour la durée d'un bloc.
+class PowerHold {
+public:
+    explicit PowerHold(PowerManager& power) : _power(power) { _power.hold(); }
+    ~PowerHold() { _power.release(); }
+
+private:
+    PowerManager& _power;
+};
@@ -0,0 +1,36 @@
+#include "sample_ring.h"
+
+bool SampleRing::begin(size_t capacity) {
+    clear();
+    if (_slots && capacity == _capacity) return true;
+    free(_slots);
+    _slots = nullptr;
+    _psram = false;
+    size_t bytes = capacity * sizeof(TelemetryRecord);
+#ifdef BOARD_HAS_PSRAM
+    if (psramFound()) {
+        _slots = (TelemetryRecord*)ps_malloc(bytes);
+        _psram = _slots != nullptr;
+    }
+#endif
+    if (!_slots) _slots = (TelemetryRecord*)malloc(bytes);
+    _capacity = _slots ? capacity : 0;
+    return _slots != nullptr;
+}
+
+void SampleRing::push(uint32_t ts, float temp, int aqi, bool isOpen) {
+    if (_capacity == 0) return;
+    if (_count == _capacity) {
+        _first = (_first + 1) % _capacity;
+        _count--;
+    }
+    TelemetryRecord& r = _slots[(_first + _count) % _capacity];
+    r.seq = 0;
+    r.ts = ts;
+    r.temp10 = (int16_t)lroundf(temp * 10);
+    r.aqi = (uint16_t)constrain(aqi, 0, 0xFFFF);
+    r.isOpen = isOpen;
+    r.reserved = 0;
+    r.check = 0;
+    _count++;
+}
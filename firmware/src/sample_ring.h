@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Arduino.h>
+#include "telemetry_store.h"
+
+// Échantillons en attente d'envoi groupé, en anneau : en PSRAM quand la carte
+// en a une (BOARD_HAS_PSRAM), sinon dans le tas interne. Plein, l'anneau
+// écrase le plus ancien.
+class SampleRing {
+public:
+    bool begin(size_t capacity);
+    void push(uint32_t ts, float temp, int aqi, bool isOpen);
+    // i = 0 : le plus ancien.
+    const TelemetryRecord& at(size_t i) const { return _slots[(_first + i) % _capacity]; }
+    size_t count() const { return _count; }
+    size_t capacity() const { return _capacity; }
+    bool inPsram() const { return _psram; }
+    void clear() { _first = 0; _count = 0; }
+
+private:
+    TelemetryRecord* _slots = nullptr;
+    size_t _capacity = 0;
+    size_t _first = 0;
+    size_t _count = 0;
+    bool _psram = false;
+};
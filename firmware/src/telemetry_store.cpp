@@ -0,0 +1,143 @@
+#include "telemetry_store.h"
+
+uint16_t TelemetryStore::checksum(const TelemetryRecord& r) {
+    // Fletcher-16 sur tout sauf le champ check ; inversé pour qu'un emplacement à zéro soit invalide.
+    const uint8_t* p = (const uint8_t*)&r;
+    uint16_t a = 0, b = 0;
+    for (size_t i = 0; i < offsetof(TelemetryRecord, check); i++) {
+        a = (a + p[i]) % 255;
+        b = (b + a) % 255;
+    }
+    return ((b << 8) | a) ^ 0xA5A5;
+}
+
+void TelemetryStore::segmentPath(uint32_t segment, char* out, size_t size) const {
+    snprintf(out, size, "%s%u.bin", _base, (unsigned)(segment % _segments));
+}
+
+bool TelemetryStore::begin(const char* base, uint32_t capacity) {
+    _file.close();
+    _fileSegment = NO_SEGMENT;
+    _ready = false;
+    _buffered = 0;
+    _dropped = 0;
+    _head = _tail = 0;
+    snprintf(_base, sizeof(_base), "%s", base);
+    // Un segment de plus que la capacité : celui qu'on remplit ne rogne pas l'historique
+    _segments = (max(capacity, (uint32_t)1) + TELEMETRY_SEGMENT - 1) / TELEMETRY_SEGMENT + 1;
+    if (!LittleFS.begin(true)) {
+        Serial.println("telemetry: LittleFS indisponible, pas de stockage en coupure");
+        return false;
+    }
+
+    // Tête et queue : plus grand et plus petit numéro valide des segments présents
+    bool found = false;
+    char path[32];
+    TelemetryRecord r;
+    for (uint32_t slot = 0; slot < _segments; slot++) {
+        segmentPath(slot, path, sizeof(path));
+        if (!LittleFS.exists(path)) continue;
+        File f = LittleFS.open(path, FILE_READ);
+        while (f.read((uint8_t*)&r, sizeof(r)) == sizeof(r)) {
+            if (r.check != checksum(r) || (r.seq / TELEMETRY_SEGMENT) % _segments != slot) continue;
+            if (!found || r.seq < _tail) _tail = r.seq;
+            if (!found || r.seq >= _head) _head = r.seq + 1;
+            found = true;
+        }
+    }
+    _ready = true;
+    if (pending() > 0) Serial.printf("telemetry: %u échantillons en attente (%u segments)\n", (unsigned)pending(), (unsigned)_segments);
+    return true;
+}
+
+void TelemetryStore::push(uint32_t ts, float temp, int aqi, bool isOpen) {
+    if (!_ready) return;
+    TelemetryRecord& r = _buffer[_buffered++];
+    r.seq = _head++;
+    r.ts = ts;
+    r.temp10 = (int16_t)lroundf(temp * 10);
+    r.aqi = (uint16_t)constrain(aqi, 0, 0xFFFF);
+    r.isOpen = isOpen;
+    r.reserved = 0;
+    r.check = checksum(r);
+
+    // Segment recommencé : ce qu'il gardait est perdu
+    uint32_t segment = r.seq / TELEMETRY_SEGMENT;
+    if (segment >= _segments) {
+        uint32_t oldest = (segment - _segments + 1) * TELEMETRY_SEGMENT;
+        if (_tail < oldest) {
+            _dropped += oldest - _tail;
+            _tail = oldest;
+        }
+    }
+    if (_buffered == TELEMETRY_FLUSH) flush();
+}
+
+void TelemetryStore::flush() {
+    for (size_t i = 0; i < _buffered; i++) {
+        const TelemetryRecord& r = _buffer[i];
+        uint32_t segment = r.seq / TELEMETRY_SEGMENT;
+        if (segment != _fileSegment) {
+            if (_fileSegment != NO_SEGMENT) _file.flush();
+            _file.close();
+            char path[32];
+            segmentPath(segment, path, sizeof(path));
+            // Début de segment : le fichier de cet emplacement repart de zéro ; sinon on le complète
+            _file = LittleFS.open(path, offset(r.seq) == 0 ? FILE_WRITE : "r+");
+            if (!_file) _file = LittleFS.open(path, FILE_WRITE);
+            _fileSegment = segment;
+        }
+        // Un enregistrement écrit à moitié avant une coupure est recouvert par le suivant
+        if (_file && _file.seek(offset(r.seq))) _file.write((const uint8_t*)&r, sizeof(r));
+    }
+    if (_buffered > 0 && _file) _file.flush();
+    _buffered = 0;
+}
+
+size_t TelemetryStore::peek(TelemetryRecord* out, size_t max) {
+    if (!_ready) return 0;
+    flush();
+    size_t n = 0;
+    File f;
+    uint32_t opened = NO_SEGMENT;
+    for (uint32_t seq = _tail; seq != _head && n < max; seq++) {
+        uint32_t segment = seq / TELEMETRY_SEGMENT;
+        if (segment != opened) {
+            char path[32];
+            segmentPath(segment, path, sizeof(path));
+            f = LittleFS.exists(path) ? LittleFS.open(path, FILE_READ) : File();
+            opened = segment;
+        }
+        TelemetryRecord r;
+        bool valid = f && f.seek(offset(seq)) && f.read((uint8_t*)&r, sizeof(r)) == sizeof(r) &&
+                     r.seq == seq && r.check == checksum(r);
+        if (!valid) {
+            // Perdu (coupure d'alimentation avant l'écriture) : on le saute définitivement.
+            if (n == 0) _tail = seq + 1;
+            continue;
+        }
+        out[n++] = r;
+    }
+    return n;
+}
+
+void TelemetryStore::ack(uint32_t seq) {
+    uint32_t from = _tail / TELEMETRY_SEGMENT;
+    _tail = seq + 1;
+    char path[32];
+    if (_tail == _head) {
+        // Tout est parti : plus aucun segment, la numérotation repart de zéro
+        _file.close();
+        _fileSegment = NO_SEGMENT;
+        for (uint32_t segment = from; segment <= (_head - 1) / TELEMETRY_SEGMENT; segment++) {
+            segmentPath(segment, path, sizeof(path));
+            LittleFS.remove(path);
+        }
+        _head = _tail = 0;
+        return;
+    }
+    for (uint32_t segment = from; segment < _tail / TELEMETRY_SEGMENT; segment++) {
+        segmentPath(segment, path, sizeof(path));
+        LittleFS.remove(path);
+    }
+}
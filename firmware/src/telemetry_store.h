@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// Échantillon tel qu'écrit en flash (16 octets).
+struct TelemetryRecord {
+    uint32_t seq;
+    uint32_t ts;      // epoch (s)
+    int16_t temp10;   // température × 10
+    uint16_t aqi;
+    uint8_t isOpen;
+    uint8_t reserved;
+    uint16_t check;   // détecte les emplacements vides ou écrits à moitié
+};
+
+// File d'attente des échantillons non envoyés, en segments LittleFS écrits en
+// ajout seul (`<base>0.bin` à `<base>N.bin`, TELEMETRY_SEGMENT échantillons,
+// un bloc de 4 Ko chacun). LittleFS ne réécrit pas un bloc en place : un ajout
+// ne recopie que le dernier bloc du segment en cours, un segment plein n'est
+// plus touché jusqu'à sa suppression. Rien n'est écrit tant que le backend
+// répond ; en coupure, les échantillons sont groupés par TELEMETRY_FLUSH. Au-delà
+// de `capacity`, le segment le plus ancien est recommencé.
+// Un segment acquitté en entier est supprimé ; la position de lecture dans le
+// segment entamé ne vit qu'en RAM : après un redémarrage en plein rattrapage,
+// ses échantillons déjà reçus repartent, et le backend écarte les doublons.
+class TelemetryStore {
+public:
+    bool begin(const char* base, uint32_t capacity);
+    void push(uint32_t ts, float temp, int aqi, bool isOpen);
+    // Copie au plus `max` échantillons, du plus ancien au plus récent.
+    size_t peek(TelemetryRecord* out, size_t max);
+    // Le backend a reçu tout jusqu'à `seq` inclus.
+    void ack(uint32_t seq);
+    uint32_t pending() const { return _head - _tail; }
+    uint32_t dropped() const { return _dropped; }
+
+    static const uint32_t TELEMETRY_SEGMENT = 256;
+
+private:
+    static const size_t TELEMETRY_FLUSH = 8;
+    static const uint32_t NO_SEGMENT = 0xFFFFFFFF;
+
+    void flush();
+    void segmentPath(uint32_t segment, char* out, size_t size) const;
+    static uint16_t checksum(const TelemetryRecord& r);
+    static size_t offset(uint32_t seq) { return (seq % TELEMETRY_SEGMENT) * sizeof(TelemetryRecord); }
+
+    File _file;                        // segment en cours d'écriture
+    uint32_t _fileSegment = NO_SEGMENT;
+    char _base[24] = "";
+    bool _ready = false;
+    uint32_t _segments = 0;  // fichiers en rotation
+    uint32_t _head = 0;      // prochain numéro attribué
+    uint32_t _tail = 0;      // plus ancien numéro non acquitté
+    uint32_t _dropped = 0;   // écrasés avant d'avoir pu partir
+    TelemetryRecord _buffer[TELEMETRY_FLUSH];
+    size_t _buffered = 0;
+};
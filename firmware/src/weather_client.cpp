@@ -0,0 +1,153 @@
+#include "weather_client.h"
+
+void WeatherClient::begin(const char* host) {
+    _host = host;
+    _client.setInsecure(); // comme HTTPClient::begin(url) sans certificat : pas de vérification
+    _http.setReuse(true);
+    _http.setTimeout(5000);
+    static const char* keys[] = { "Transfer-Encoding", "Keep-Alive" };
+    _http.collectHeaders(keys, 2);
+}
+
+void WeatherClient::reset() {
+    _http.end();
+    _client.stop();
+}
+
+void WeatherClient::release(uint32_t nextMs) {
+    if (nextMs >= _keepAliveMs) reset();
+}
+
+int WeatherClient::request(const char* path, JsonDocument& doc, const JsonDocument& filter, DeserializationError& err) {
+    unsigned long t0 = millis();
+    _timing.clear();
+    char url[256];
+    snprintf(url, sizeof(url), "https://%s%s", _host, path);
+    _http.begin(_client, url);
+    bool warm = _client.connected();
+    if (!warm) {
+        // Connexion explicite (après begin(), qui coupe tout socket vers un autre hôte)
+        // pour chronométrer le handshake seul ; GET() la trouve ouverte et la reprend.
+        // La résolution d'abord, à part : connect() trouve ensuite le nom dans le
+        // cache DNS et garde le nom d'hôte pour le SNI.
+        IPAddress ip;
+        uint32_t d0 = micros();
+        if (!WiFi.hostByName(_host, ip)) return HTTPC_ERROR_CONNECTION_REFUSED;
+        uint32_t d1 = micros();
+        _timing.set(STAGE_DNS, d1 - d0);
+        if (!_client.connect(_host, 443)) return HTTPC_ERROR_CONNECTION_REFUSED;
+        _timing.set(STAGE_TLS, micros() - d1);
+        _stats.handshakes++;
+        _stats.handshakeMs = millis() - t0;
+    }
+    _client.arm();
+    int code = _http.GET();
+    if (code <= 0) return code;
+    uint32_t headersEnd = micros();
+    String keepAlive = _http.header("Keep-Alive");
+    int timeout = keepAlive.indexOf("timeout=");
+    _keepAliveMs = timeout >= 0 ? keepAlive.substring(timeout + 8).toInt() * 1000UL : WEATHER_KEEPALIVE_MS;
+    if (code != HTTP_CODE_OK) {
+        reset(); // corps d'erreur non lu : la connexion ne peut pas resservir
+        return code;
+    }
+
+    unsigned long p0 = micros();
+    // Parsing direct depuis le socket : seuls les champs du filtre sont gardés en RAM
+    if (_http.header("Transfer-Encoding").equalsIgnoreCase("chunked")) {
+        ChunkedStream body(_http.getStream());
+        err = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+        body.drain();
+    } else {
+        err = deserializeJson(doc, _http.getStream(), DeserializationOption::Filter(filter));
+    }
+    _stats.parseUs = micros() - p0;
+    if (_client.firstByte()) {
+        _timing.set(STAGE_SEND, _client.sendEnd() - _client.sendStart());
+        _timing.set(STAGE_WAIT, _client.firstByte() - _client.sendEnd());
+        _timing.set(STAGE_BODY, headersEnd - _client.firstByte());
+    }
+    _timing.set(STAGE_PARSE, _stats.parseUs);
+    _http.end(); // vide le reste du corps ; le socket reste ouvert si le serveur l'accepte
+    _lastUse = millis();
+
+    uint32_t elapsed = millis() - t0;
+    if (warm) _stats.warmMs = elapsed;
+    else _stats.coldMs = elapsed;
+    _stats.fetches++;
+    return code;
+}
+
+int WeatherClient::fetch(const char* path, JsonDocument& doc, const JsonDocument& filter, DeserializationError& err) {
+    // Gardée au-delà de son expiration (release() non appelé) : déjà fermée côté serveur
+    if (_client.connected() && millis() - _lastUse >= _keepAliveMs) reset();
+    bool warm = _client.connected();
+    int code = request(path, doc, filter, err);
+    if (code > 0 || !warm) {
+        if (code <= 0) reset();
+        return code;
+    }
+
+    // La connexion gardée a été fermée côté serveur entre deux récupérations :
+    // une seule reprise, avec un handshake complet.
+    reset();
+    code = request(path, doc, filter, err);
+    if (code <= 0) reset();
+    return code;
+}
+
+// --- ChunkedStream -----------------------------------------------------------
+
+bool ChunkedStream::nextChunk() {
+    if (_done) return false;
+    long size = 0;
+    bool extension = false;
+    char c;
+    // Ligne "taille-hexa[;extension]\r\n"
+    while (_in.readBytes(&c, 1) == 1 && c != '\n') {
+        if (c == ';') extension = true;
+        if (extension) continue;
+        char lc = c | 0x20;
+        if (c >= '0' && c <= '9') size = size * 16 + (c - '0');
+        else if (lc >= 'a' && lc <= 'f') size = size * 16 + (lc - 'a' + 10);
+    }
+    if (size > 0) {
+        _left = size;
+        return true;
+    }
+
+    // Dernier morceau (ou flux coupé) : on saute les trailers jusqu'à la ligne vide.
+    _done = true;
+    String line;
+    do {
+        line = _in.readStringUntil('\n');
+        line.trim();
+    } while (line.length() > 0);
+    return false;
+}
+
+int ChunkedStream::available() {
+    if (_done) return 0;
+    int n = _in.available();
+    return (_left > 0 && n > _left) ? (int)_left : n;
+}
+
+int ChunkedStream::read() {
+    if (_left == 0 && !nextChunk()) return -1;
+    char c;
+    if (_in.readBytes(&c, 1) != 1) return -1;
+    if (--_left == 0) {
+        char crlf[2];
+        _in.readBytes(crlf, 2);
+    }
+    return (uint8_t)c;
+}
+
+int ChunkedStream::peek() {
+    if (_left == 0 && !nextChunk()) return -1;
+    return _in.peek();
+}
+
+void ChunkedStream::drain() {
+    while (read() >= 0) {}
+}
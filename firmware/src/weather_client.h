@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include "net_timing.h"
+
+// Temps passé sur les récupérations météo, remonté dans la télémétrie.
+struct WeatherStats {
+    uint32_t fetches = 0;
+    uint32_t handshakes = 0;   // connexions TLS neuves
+    uint32_t handshakeMs = 0;  // durée du dernier handshake seul
+    uint32_t coldMs = 0;       // dernière requête complète avec handshake
+    uint32_t warmMs = 0;       // dernière requête sur la connexion gardée
+    uint32_t parseUs = 0;      // dernier parsing (lecture du socket comprise)
+};
+
+// Délai de fermeture des connexions inactives côté serveur, quand la réponse ne
+// l'annonce pas (« Keep-Alive: timeout= ») : celui de Node, parmi les plus courts.
+#define WEATHER_KEEPALIVE_MS 5000
+
+// Client Open-Meteo : la connexion TLS (HTTP/1.1 keep-alive) n'est gardée que
+// si la récupération suivante tombe avant que le serveur ne la ferme. Sinon
+// elle est fermée tout de suite : pas de requête perdue sur un socket mort, et
+// le tas de mbedTLS (≈ 40 Ko) est rendu entre deux récupérations.
+class WeatherClient {
+public:
+    void begin(const char* host);
+    // GET https://<host><path>, parsé en flux avec le filtre. Renvoie le code HTTP (<= 0 : erreur).
+    int fetch(const char* path, JsonDocument& doc, const JsonDocument& filter, DeserializationError& err);
+    void reset();
+    // Prochaine récupération dans `nextMs` : ferme la connexion si elle expire avant.
+    void release(uint32_t nextMs);
+    const WeatherStats& stats() const { return _stats; }
+    // Étapes de la dernière récupération réussie ; le corps étant parsé en flux,
+    // `body` s'arrête aux en-têtes et `parse` comprend la lecture du socket.
+    const NetTiming& timing() const { return _timing; }
+
+private:
+    int request(const char* path, JsonDocument& doc, const JsonDocument& filter, DeserializationError& err);
+
+    TimedClient<WiFiClientSecure> _client;
+    HTTPClient _http;
+    const char* _host = "";
+    uint32_t _keepAliveMs = WEATHER_KEEPALIVE_MS;  // annoncé par la dernière réponse
+    unsigned long _lastUse = 0;
+    WeatherStats _stats;
+    NetTiming _timing = {};
+};
+
+// Corps HTTP/1.1 « Transfer-Encoding: chunked » lu comme un flux continu,
+// pour que le parsing reste direct depuis le socket.
+class ChunkedStream : public Stream {
+public:
+    explicit ChunkedStream(Stream& in) : _in(in) {}
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override { return 0; }
+    // Consomme la fin du corps : la connexion reste utilisable pour la requête suivante.
+    void drain();
+
+private:
+    bool nextChunk();
+
+    Stream& _in;
+    long _left = 0;
+    bool _done = false;
+};
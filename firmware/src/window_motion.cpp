@@ -0,0 +1,81 @@
+#include "window_motion.h"
+
+bool WindowMotion::begin(Servo& servo, int closedUs, int openUs, float speed, float accel) {
+    _servo = &servo;
+    _closedUs = closedUs;
+    _openUs = openUs;
+    setProfile(speed, accel);
+    if (!_lock) _lock = xSemaphoreCreateMutex();
+    if (_timer) return true;
+    esp_timer_create_args_t args = {};
+    args.callback = onFrame;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "window";
+    args.skip_unhandled_events = true;
+    return esp_timer_create(&args, &_timer) == ESP_OK;
+}
+
+void WindowMotion::setProfile(float speed, float accel) {
+    _speed = max(speed, 1.0f);
+    _accel = max(accel, 1.0f);
+}
+
+void WindowMotion::moveTo(float percent) {
+    percent = constrain(percent, 0.0f, 100.0f);
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if (percent != _target || _moving) {
+        if (!_moving) _moves++;
+        _target = percent;
+        _moving = true;
+        // Premier pas tout de suite, la suite au rythme de la trame
+        step();
+        holdPower();
+        if (_moving && !esp_timer_is_active(_timer)) esp_timer_start_periodic(_timer, FRAME_US);
+    }
+    xSemaphoreGive(_lock);
+}
+
+void WindowMotion::onFrame(void* arg) {
+    WindowMotion* self = (WindowMotion*)arg;
+    xSemaphoreTake(self->_lock, portMAX_DELAY);
+    self->step();
+    self->holdPower();
+    if (!self->_moving) esp_timer_stop(self->_timer);
+    xSemaphoreGive(self->_lock);
+}
+
+void WindowMotion::step() {
+    const float dt = FRAME_US / 1e6f;
+    float position = _position;
+    float distance = _target - position;
+    float direction = distance > 0 ? 1.0f : -1.0f;
+
+    // Vitesse visée : le palier, ou moins si la distance restante ne permet
+    // plus de freiner à temps (v² = 2·a·d), puis rampe d'accélération.
+    float wanted = direction * min(_speed, sqrtf(2.0f * _accel * fabsf(distance)));
+    float delta = _accel * dt;
+    _velocity = _velocity < wanted ? min(wanted, _velocity + delta) : max(wanted, _velocity - delta);
+    position += _velocity * dt;
+
+    // Arrivée (ou dépassement de la cible au dernier pas)
+    if ((_target - position) * direction <= 0.05f) {
+        position = _target;
+        _velocity = 0;
+        _moving = false;
+    }
+    _position = position;
+
+    int us = _closedUs + (int)lroundf(position * (_openUs - _closedUs) / 100.0f);
+    if (us != _lastUs) {
+        _servo->writeMicroseconds(us);
+        _lastUs = us;
+    }
+}
+
+void WindowMotion::holdPower() {
+    if (!_power || _held == _moving) return;
+    _held = _moving;
+    if (_held) _power->hold();
+    else _power->release();
+}
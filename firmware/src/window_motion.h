@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP32Servo.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "power.h"
+
+// Ouverture de la fenêtre en pourcentage (0 = fermée, 100 = ouverte), atteinte
+// par un profil trapézoïdal : accélération, palier de vitesse, freinage. Le
+// profil avance dans un esp_timer cadencé sur la trame du servo (20 ms) :
+// loop() ne fait que fixer la cible, la course se fait en arrière-plan et le
+// timer s'arrête une fois la cible atteinte. Une nouvelle cible en cours de
+// route est prise à la volée, sans à-coup.
+class WindowMotion {
+public:
+    // `closedUs` / `openUs` : impulsions des deux butées ; `speed` en %/s,
+    // `accel` en %/s². La fenêtre est supposée fermée au démarrage.
+    bool begin(Servo& servo, int closedUs, int openUs, float speed, float accel);
+    void setProfile(float speed, float accel);
+    // Tient `power` éveillé pendant chaque course (light-sleep : trame du servo à l'heure).
+    void setPower(PowerManager* power) { _power = power; }
+    void moveTo(float percent);
+
+    float position() const { return _position; }
+    float target() const { return _target; }
+    bool moving() const { return _moving; }
+    uint32_t moves() const { return _moves; } // mouvements commencés depuis le boot
+
+private:
+    static const uint32_t FRAME_US = 20000; // une impulsion servo à 50 Hz
+    static void onFrame(void* arg);
+    void step(); // sous _lock
+    void holdPower(); // sous _lock, après step()
+
+    Servo* _servo = nullptr;
+    PowerManager* _power = nullptr;
+    bool _held = false;
+    esp_timer_handle_t _timer = nullptr;
+    SemaphoreHandle_t _lock = nullptr;
+    int _closedUs = 0;
+    int _openUs = 0;
+    float _speed = 100;
+    float _accel = 200;
+    volatile float _position = 0;
+    volatile float _target = 0;
+    float _velocity = 0; // %/s, signée
+    int _lastUs = -1;
+    volatile bool _moving = false;
+    uint32_t _moves = 0;
+};
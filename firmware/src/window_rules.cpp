@@ -0,0 +1,169 @@
+#include "window_rules.h"
+
+#include <cmath>
+
+const char* RuleSet::DEFAULT_RULES = "temp>30|aqi>50:CLOSE;*:OPEN";
+
+namespace {
+
+const char* VAR_NAMES[RULE_VAR_COUNT] = { "temp", "aqi", "wind", "rain", "humidity", "hour" };
+
+// Curseur du compilateur ; les blancs sont ignorés partout.
+struct Cursor {
+    const char* p;
+
+    char peek() {
+        while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+        return *p;
+    }
+    bool eat(char c) {
+        if (peek() != c) return false;
+        p++;
+        return true;
+    }
+    // Mot [a-zA-Z]+ en minuscules dans `out`.
+    bool word(char* out, size_t size) {
+        peek();
+        size_t n = 0;
+        while (isalpha((unsigned char)*p)) {
+            if (n + 1 < size) out[n++] = tolower((unsigned char)*p);
+            p++;
+        }
+        out[n] = '\0';
+        return n > 0;
+    }
+};
+
+}  // namespace
+
+const char* RuleSet::actionName(RuleAction action) {
+    switch (action) {
+        case RULE_OPEN: return "OPEN";
+        case RULE_CLOSE: return "CLOSE";
+        default: return "HOLD";
+    }
+}
+
+bool RuleSet::compile(const char* text, char* error, size_t errorSize) {
+    // Compilé à part : un texte invalide ne touche pas l'ensemble en service
+    RuleSet next;
+    memcpy(next._bands, _bands, sizeof(_bands));
+    const char* start = text ? text : "";
+    Cursor in = { start };
+    const char* fault = nullptr;
+    uint8_t rule = 0;
+    uint8_t firstTerm = 0;
+
+    while (!fault && in.peek()) {
+        // Termes de la règle, action inconnue jusqu'au ':'
+        do {
+            if (next._termCount == MAX_TERMS) { fault = "trop de termes"; break; }
+            uint32_t mask = 0;
+            if (!in.eat('*')) {
+                do {
+                    char name[12];
+                    int var = -1;
+                    if (in.word(name, sizeof(name))) {
+                        for (int i = 0; i < RULE_VAR_COUNT; i++) {
+                            if (!strcmp(name, VAR_NAMES[i])) var = i;
+                        }
+                    }
+                    if (var < 0) { fault = "variable inconnue"; break; }
+
+                    Op op;
+                    if (in.eat('>')) op = in.eat('=') ? OP_GE : OP_GT;
+                    else if (in.eat('<')) op = in.eat('=') ? OP_LE : OP_LT;
+                    else if (in.eat('!') && in.eat('=')) op = OP_NE;
+                    else if (in.eat('=')) { in.eat('='); op = OP_EQ; }
+                    else { fault = "opérateur attendu"; break; }
+
+                    in.peek();
+                    char* end;
+                    float value = strtof(in.p, &end);
+                    if (end == in.p) { fault = "nombre attendu"; break; }
+                    in.p = end;
+
+                    // Condition partagée si elle existe déjà
+                    uint8_t bit = 0;
+                    while (bit < next._conditionCount && !(next._conditions[bit].var == var &&
+                           next._conditions[bit].op == op && next._conditions[bit].value == value)) bit++;
+                    if (bit == next._conditionCount) {
+                        if (bit == MAX_CONDITIONS) { fault = "trop de conditions"; break; }
+                        next._conditions[bit] = { value, 0, (uint8_t)var, (uint8_t)op };
+                        next._conditionCount++;
+                    }
+                    mask |= 1UL << bit;
+                    next._uses |= 1 << var;
+                } while (in.eat('&'));
+            }
+            if (fault) break;
+            next._terms[next._termCount++] = { mask, RULE_HOLD, rule };
+        } while (in.eat('|'));
+        if (fault) break;
+
+        char name[8];
+        RuleAction action;
+        if (!in.eat(':') || !in.word(name, sizeof(name))) { fault = "action attendue"; break; }
+        if (!strcmp(name, "open")) action = RULE_OPEN;
+        else if (!strcmp(name, "close")) action = RULE_CLOSE;
+        else if (!strcmp(name, "hold")) action = RULE_HOLD;
+        else { fault = "action inconnue"; break; }
+        for (uint8_t t = firstTerm; t < next._termCount; t++) next._terms[t].action = action;
+        firstTerm = next._termCount;
+        rule++;
+
+        if (!in.eat(';') && in.peek()) fault = "';' attendu";
+    }
+    if (!fault && next._termCount == 0) fault = "aucune règle";
+
+    if (fault) {
+        if (error && errorSize) snprintf(error, errorSize, "%s (caractère %d)", fault, (int)(in.p - start));
+        return false;
+    }
+    next.updateReleases();
+    *this = next;
+    return true;
+}
+
+void RuleSet::setHysteresis(RuleVar var, float band) {
+    if (var >= RULE_VAR_COUNT) return;
+    _bands[var] = max(band, 0.0f);
+    updateReleases();
+}
+
+void RuleSet::updateReleases() {
+    for (uint8_t i = 0; i < _conditionCount; i++) {
+        Condition& c = _conditions[i];
+        float band = _bands[c.var];
+        // > et >= relâchent sous le seuil, < et <= au-dessus ; = et != sans bande
+        c.release = c.op == OP_GT || c.op == OP_GE ? -band : (c.op == OP_LT || c.op == OP_LE ? band : 0);
+    }
+}
+
+RuleAction RuleSet::evaluate(const RuleInputs& in, int* rule) {
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < _conditionCount; i++) {
+        const Condition& c = _conditions[i];
+        float x = in.v[c.var];
+        float value = c.value + c.release * (float)((_latched >> i) & 1);
+        bool hit;
+        switch (c.op) {
+            case OP_GT: hit = x > value; break;
+            case OP_GE: hit = x >= value; break;
+            case OP_LT: hit = x < value; break;
+            case OP_LE: hit = x <= value; break;
+            case OP_EQ: hit = x == value; break;
+            default: hit = !std::isnan(x) && x != value; break;
+        }
+        bits |= (uint32_t)hit << i;
+    }
+    _latched = bits;
+    for (uint8_t t = 0; t < _termCount; t++) {
+        if ((bits & _terms[t].mask) == _terms[t].mask) {
+            if (rule) *rule = _terms[t].rule;
+            return (RuleAction)_terms[t].action;
+        }
+    }
+    if (rule) *rule = -1;
+    return RULE_HOLD;
+}
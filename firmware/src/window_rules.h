@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Grandeurs lues par les règles du mode AUTO. NAN : inconnue (champ météo non
+// demandé, heure pas encore synchronisée), toute comparaison est alors fausse.
+enum RuleVar : uint8_t { RULE_TEMP, RULE_AQI, RULE_WIND, RULE_RAIN, RULE_HUMIDITY, RULE_HOUR, RULE_VAR_COUNT };
+enum RuleAction : uint8_t { RULE_HOLD, RULE_OPEN, RULE_CLOSE };
+
+struct RuleInputs {
+    float v[RULE_VAR_COUNT];
+};
+
+// Règles du mode AUTO, compilées en table au chargement plutôt que câblées :
+//
+//   temp>30|aqi>50:CLOSE;rain>0.2&wind>40:CLOSE;hour>=22|hour<7:HOLD;*:OPEN
+//
+// Les règles sont essayées dans l'ordre, la première vraie donne l'action
+// (OPEN, CLOSE, HOLD = ne pas bouger) ; aucune vraie : HOLD. `&` lie plus fort
+// que `|`, `*` est toujours vrai. Variables : temp (°C), aqi, wind (km/h),
+// rain (mm), humidity (%), hour (heure locale décimale, 0 à 24) ; opérateurs
+// > >= < <= = !=.
+//
+// Chaque règle devient une disjonction de termes, chaque terme un masque de
+// conditions ; les conditions identiques sont partagées. L'évaluation calcule
+// une fois chaque condition (un bit), puis cherche le premier terme dont le
+// masque est couvert : un coût borné par la taille de la table, sans parsing
+// ni allocation.
+//
+// Hystérésis : une comparaison d'ordre vraie à l'évaluation précédente ne
+// redevient fausse qu'une fois son seuil recroisé de la bande de sa grandeur
+// (avec une bande de 1 °C, `temp>30` passe vrai au-dessus de 30 et ne
+// retombe qu'à 29). L'évaluation garde donc un état, remis à zéro par compile().
+class RuleSet {
+public:
+    static const size_t MAX_CONDITIONS = 32; // bits du masque
+    static const size_t MAX_TERMS = 16;
+    static const char* DEFAULT_RULES;        // l'ancien seuil fixe
+
+    // false si le texte est invalide : l'ensemble courant est alors gardé et
+    // `error` (si fourni) décrit la faute.
+    bool compile(const char* text, char* error = nullptr, size_t errorSize = 0);
+    // `rule` (si fourni) : indice de la règle retenue, -1 si aucune.
+    RuleAction evaluate(const RuleInputs& in, int* rule = nullptr);
+    // Bande d'hystérésis d'une grandeur (0 : aucune), gardée d'une compilation à l'autre.
+    void setHysteresis(RuleVar var, float band);
+
+    // Masque (1 << RuleVar) des grandeurs lues, pour ne demander que les champs utiles.
+    uint8_t uses() const { return _uses; }
+    size_t conditions() const { return _conditionCount; }
+    size_t terms() const { return _termCount; }
+
+    static const char* actionName(RuleAction action);
+
+private:
+    enum Op : uint8_t { OP_GT, OP_GE, OP_LT, OP_LE, OP_EQ, OP_NE };
+    struct Condition {
+        float value;
+        float release; // décalage du seuil tant que la condition est vraie
+        uint8_t var;
+        uint8_t op;
+    };
+    struct Term {
+        uint32_t mask;   // conditions à réunir (0 : toujours vrai)
+        uint8_t action;
+        uint8_t rule;
+    };
+
+    Condition _conditions[MAX_CONDITIONS];
+    Term _terms[MAX_TERMS];
+    uint8_t _conditionCount = 0;
+    uint8_t _termCount = 0;
+    uint8_t _uses = 0;
+    uint32_t _latched = 0; // conditions vraies à l'évaluation précédente
+    float _bands[RULE_VAR_COUNT] = {};
+
+    void updateReleases();
+};
@@ -0,0 +1,185 @@
+// Compilateur et évaluation des règles du mode AUTO (window_rules.h).
+//
+//   pio test -e test
+#include <gtest/gtest.h>
+#include <cmath>
+
+#include "window_rules.h"
+
+namespace {
+
+RuleInputs inputs(float temp, float aqi, float wind = NAN, float rain = NAN, float humidity = NAN, float hour = NAN) {
+    return { { temp, aqi, wind, rain, humidity, hour } };
+}
+
+RuleSet compiled(const char* text) {
+    RuleSet rules;
+    char error[48] = "";
+    EXPECT_TRUE(rules.compile(text, error, sizeof(error))) << text << " : " << error;
+    return rules;
+}
+
+TEST(RulesCompile, DefaultRules) {
+    RuleSet rules = compiled(RuleSet::DEFAULT_RULES);
+    EXPECT_EQ(rules.conditions(), 2u);
+    EXPECT_EQ(rules.terms(), 3u);
+    EXPECT_EQ(rules.uses(), (1 << RULE_TEMP) | (1 << RULE_AQI));
+}
+
+TEST(RulesCompile, SharedConditionsAndUses) {
+    RuleSet rules = compiled("temp>30&wind>40:CLOSE; wind>40|rain>=0.2:CLOSE;*:OPEN");
+    EXPECT_EQ(rules.conditions(), 3u);
+    EXPECT_EQ(rules.terms(), 4u);
+    EXPECT_EQ(rules.uses(), (1 << RULE_TEMP) | (1 << RULE_WIND) | (1 << RULE_RAIN));
+}
+
+TEST(RulesCompile, CaseAndBlanksIgnored) {
+    RuleSet rules = compiled(" TEMP > 30 : close ;\n * : Open ");
+    EXPECT_EQ(rules.evaluate(inputs(31, 0)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(20, 0)), RULE_OPEN);
+}
+
+TEST(RulesCompile, GrammarErrors) {
+    const char* invalid[] = {
+        "",                     // aucune règle
+        "   ",
+        "pressure>3:OPEN",      // variable inconnue
+        "temp 30:OPEN",         // opérateur attendu
+        "temp>:OPEN",           // nombre attendu
+        "temp>30",              // action attendue
+        "temp>30:",
+        "temp>30:SHUT",         // action inconnue
+        "temp>30:OPEN*:HOLD",   // ';' attendu
+        "temp>30&:OPEN",
+        "|temp>30:OPEN",
+    };
+    for (const char* text : invalid) {
+        RuleSet rules;
+        char error[48] = "";
+        EXPECT_FALSE(rules.compile(text, error, sizeof(error))) << text;
+        EXPECT_NE(error[0], '\0') << text;
+    }
+}
+
+TEST(RulesCompile, InvalidTextKeepsRules) {
+    RuleSet rules = compiled("temp>30:CLOSE;*:OPEN");
+    char error[48];
+    EXPECT_FALSE(rules.compile("temp>>30:CLOSE", error, sizeof(error)));
+    EXPECT_EQ(rules.evaluate(inputs(31, 0)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(20, 0)), RULE_OPEN);
+}
+
+TEST(RulesCompile, TableLimits) {
+    std::string terms;
+    for (size_t i = 0; i <= RuleSet::MAX_TERMS; i++) terms += (i ? "|temp>" : "temp>") + std::to_string(i);
+    RuleSet rules;
+    EXPECT_FALSE(rules.compile((terms + ":OPEN").c_str()));
+
+    std::string conditions;
+    for (size_t i = 0; i <= RuleSet::MAX_CONDITIONS; i++) conditions += (i ? "&temp>" : "temp>") + std::to_string(i);
+    EXPECT_FALSE(rules.compile((conditions + ":OPEN").c_str()));
+}
+
+TEST(RulesEvaluate, FirstTrueRuleWins) {
+    RuleSet rules = compiled("temp>30|aqi>50:CLOSE;rain>0.2&wind>40:CLOSE;temp<10:HOLD;*:OPEN");
+    int rule = -2;
+    EXPECT_EQ(rules.evaluate(inputs(31, 10), &rule), RULE_CLOSE);
+    EXPECT_EQ(rule, 0);
+    EXPECT_EQ(rules.evaluate(inputs(20, 60), &rule), RULE_CLOSE);
+    EXPECT_EQ(rule, 0);
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, 45, 1), &rule), RULE_CLOSE);
+    EXPECT_EQ(rule, 1);
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, 45, 0), &rule), RULE_OPEN);
+    EXPECT_EQ(rule, 3);
+    EXPECT_EQ(rules.evaluate(inputs(5, 10), &rule), RULE_HOLD);
+    EXPECT_EQ(rule, 2);
+}
+
+TEST(RulesEvaluate, NoRuleMatchesHolds) {
+    RuleSet rules = compiled("temp>30:CLOSE");
+    int rule = 0;
+    EXPECT_EQ(rules.evaluate(inputs(20, 10), &rule), RULE_HOLD);
+    EXPECT_EQ(rule, -1);
+}
+
+TEST(RulesEvaluate, Operators) {
+    RuleSet rules = compiled("aqi=20:CLOSE;aqi!=30&aqi>=40:OPEN;aqi<=5:HOLD;*:OPEN");
+    EXPECT_EQ(rules.evaluate(inputs(0, 20)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(0, 40)), RULE_OPEN);
+    EXPECT_EQ(rules.evaluate(inputs(0, 5)), RULE_HOLD);
+    EXPECT_EQ(rules.evaluate(inputs(0, 30)), RULE_OPEN);
+}
+
+TEST(RulesEvaluate, NanComparesFalse) {
+    RuleSet rules = compiled("wind>40:CLOSE;wind<=40:OPEN;wind!=0:HOLD;wind=0:HOLD");
+    int rule = 0;
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, NAN), &rule), RULE_HOLD);
+    EXPECT_EQ(rule, -1);
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, 50), &rule), RULE_CLOSE);
+}
+
+TEST(RulesEvaluate, NightHoursWrapAroundMidnight) {
+    RuleSet rules = compiled("hour>=22|hour<7:HOLD;*:OPEN");
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, NAN, NAN, NAN, 23.5f)), RULE_HOLD);
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, NAN, NAN, NAN, 0.0f)), RULE_HOLD);
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, NAN, NAN, NAN, 6.99f)), RULE_HOLD);
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, NAN, NAN, NAN, 7.0f)), RULE_OPEN);
+    EXPECT_EQ(rules.evaluate(inputs(20, 10, NAN, NAN, NAN, 21.9f)), RULE_OPEN);
+    // Heure inconnue : la règle de nuit ne s'applique pas
+    EXPECT_EQ(rules.evaluate(inputs(20, 10)), RULE_OPEN);
+}
+
+TEST(RulesHysteresis, LatchUntilBandCrossed) {
+    RuleSet rules;
+    rules.setHysteresis(RULE_TEMP, 1.0f);
+    ASSERT_TRUE(rules.compile("temp>30:CLOSE;*:OPEN"));
+    EXPECT_EQ(rules.evaluate(inputs(30, 0)), RULE_OPEN);
+    EXPECT_EQ(rules.evaluate(inputs(30.5f, 0)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(29.5f, 0)), RULE_CLOSE);  // sous le seuil, dans la bande
+    EXPECT_EQ(rules.evaluate(inputs(29.1f, 0)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(29.0f, 0)), RULE_OPEN);   // bande recroisée
+    EXPECT_EQ(rules.evaluate(inputs(29.5f, 0)), RULE_OPEN);   // relâchée : seuil d'origine
+}
+
+TEST(RulesHysteresis, LowerBoundReleasesAbove) {
+    RuleSet rules = compiled("temp<10:CLOSE;*:OPEN");
+    rules.setHysteresis(RULE_TEMP, 2.0f);
+    EXPECT_EQ(rules.evaluate(inputs(9, 0)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(11.5f, 0)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(12, 0)), RULE_OPEN);
+}
+
+TEST(RulesHysteresis, NanReleasesLatch) {
+    RuleSet rules;
+    rules.setHysteresis(RULE_WIND, 5.0f);
+    ASSERT_TRUE(rules.compile("wind>40:CLOSE;*:OPEN"));
+    EXPECT_EQ(rules.evaluate(inputs(20, 0, 45)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(20, 0, NAN)), RULE_OPEN);
+    EXPECT_EQ(rules.evaluate(inputs(20, 0, 38)), RULE_OPEN);
+}
+
+TEST(RulesHysteresis, BandsKeptAndLatchResetByCompile) {
+    RuleSet rules;
+    rules.setHysteresis(RULE_TEMP, 1.0f);
+    ASSERT_TRUE(rules.compile("temp>30:CLOSE;*:OPEN"));
+    EXPECT_EQ(rules.evaluate(inputs(31, 0)), RULE_CLOSE);
+    ASSERT_TRUE(rules.compile("temp>30:CLOSE;*:OPEN"));
+    EXPECT_EQ(rules.evaluate(inputs(29.5f, 0)), RULE_OPEN);   // état remis à zéro
+    EXPECT_EQ(rules.evaluate(inputs(31, 0)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(29.5f, 0)), RULE_CLOSE);  // bande gardée
+}
+
+TEST(RulesHysteresis, EqualityHasNoBand) {
+    RuleSet rules;
+    rules.setHysteresis(RULE_AQI, 5.0f);
+    ASSERT_TRUE(rules.compile("aqi=20:CLOSE;*:OPEN"));
+    EXPECT_EQ(rules.evaluate(inputs(0, 20)), RULE_CLOSE);
+    EXPECT_EQ(rules.evaluate(inputs(0, 21)), RULE_OPEN);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
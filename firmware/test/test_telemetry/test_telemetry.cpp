@@ -0,0 +1,191 @@
+// File de télémétrie en flash (telemetry_store.h) : reprise après
+// redémarrage, rotation des segments, enregistrements abîmés.
+//
+//   pio test -e test
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "hal_native.h"
+#include "telemetry_store.h"
+
+namespace {
+
+const uint32_t SEGMENT = TelemetryStore::TELEMETRY_SEGMENT;
+
+class TelemetryStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        hal::setQuiet(true);
+        hal::fsFormat();
+    }
+
+    // Échantillon n : ts et température déduits de n pour vérifier l'ordre
+    static void push(TelemetryStore& store, uint32_t from, uint32_t count) {
+        for (uint32_t n = from; n < from + count; n++) store.push(1750000000 + n, (n % 300) / 10.0f, n % 500, n & 1);
+    }
+
+    static std::vector<TelemetryRecord> drain(TelemetryStore& store, size_t max = 32) {
+        std::vector<TelemetryRecord> out(max);
+        out.resize(store.peek(out.data(), max));
+        return out;
+    }
+
+    // Recouvre un octet d'un segment, comme une écriture interrompue
+    static void corrupt(const char* path, size_t at) {
+        File f = LittleFS.open(path, "r+");
+        ASSERT_TRUE(f);
+        ASSERT_TRUE(f.seek(at));
+        uint8_t garbage = 0x5A;
+        f.write(&garbage, 1);
+    }
+};
+
+TEST_F(TelemetryStoreTest, PeekInOrderThenAck) {
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", 64));
+    push(store, 0, 20);
+    EXPECT_EQ(store.pending(), 20u);
+
+    std::vector<TelemetryRecord> batch = drain(store, 8);
+    ASSERT_EQ(batch.size(), 8u);
+    for (uint32_t i = 0; i < 8; i++) {
+        EXPECT_EQ(batch[i].seq, i);
+        EXPECT_EQ(batch[i].ts, 1750000000 + i);
+        EXPECT_EQ(batch[i].aqi, i);
+        EXPECT_EQ(batch[i].isOpen, i & 1);
+    }
+    store.ack(batch.back().seq);
+    EXPECT_EQ(store.pending(), 12u);
+    EXPECT_EQ(drain(store).front().ts, 1750000008u);
+}
+
+TEST_F(TelemetryStoreTest, ReloadFindsHeadAndTail) {
+    {
+        TelemetryStore store;
+        ASSERT_TRUE(store.begin("/tlm", 2048));
+        push(store, 0, SEGMENT + 40);  // deux segments, tout écrit (multiple de 8)
+    }
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", 2048));
+    EXPECT_EQ(store.pending(), SEGMENT + 40);
+    EXPECT_EQ(drain(store).front().seq, 0u);
+
+    // Les échantillons suivants prennent la suite, dans le segment entamé
+    push(store, SEGMENT + 40, 8);
+    std::vector<TelemetryRecord> all = drain(store, 2 * SEGMENT);
+    ASSERT_EQ(all.size(), SEGMENT + 48);
+    for (uint32_t i = 0; i < all.size(); i++) EXPECT_EQ(all[i].ts, 1750000000 + i);
+}
+
+TEST_F(TelemetryStoreTest, UnflushedSamplesLostOnReboot) {
+    {
+        TelemetryStore store;
+        ASSERT_TRUE(store.begin("/tlm", 64));
+        push(store, 0, 13);  // 8 écrits, 5 encore en RAM
+    }
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", 64));
+    EXPECT_EQ(store.pending(), 8u);
+}
+
+TEST_F(TelemetryStoreTest, AckedSegmentsAreRemoved) {
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", 2048));
+    push(store, 0, 2 * SEGMENT + 16);
+    EXPECT_TRUE(LittleFS.exists("/tlm0.bin"));
+    EXPECT_TRUE(LittleFS.exists("/tlm2.bin"));
+
+    store.ack(SEGMENT);  // premier segment entièrement reçu
+    EXPECT_FALSE(LittleFS.exists("/tlm0.bin"));
+    EXPECT_TRUE(LittleFS.exists("/tlm1.bin"));
+    EXPECT_EQ(store.pending(), SEGMENT + 15);
+
+    // Tout reçu : plus aucun fichier, la numérotation repart de zéro
+    store.ack(2 * SEGMENT + 15);
+    EXPECT_EQ(store.pending(), 0u);
+    EXPECT_FALSE(LittleFS.exists("/tlm1.bin"));
+    EXPECT_FALSE(LittleFS.exists("/tlm2.bin"));
+    push(store, 0, 8);
+    EXPECT_EQ(drain(store).front().seq, 0u);
+    EXPECT_TRUE(LittleFS.exists("/tlm0.bin"));
+}
+
+TEST_F(TelemetryStoreTest, RebootMidDrainResendsOnlyTheOpenSegment) {
+    {
+        TelemetryStore store;
+        ASSERT_TRUE(store.begin("/tlm", 2048));
+        push(store, 0, 2 * SEGMENT);
+        store.ack(SEGMENT + 31);
+    }
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", 2048));
+    EXPECT_EQ(store.pending(), SEGMENT);
+    EXPECT_EQ(drain(store).front().seq, SEGMENT);
+}
+
+TEST_F(TelemetryStoreTest, WrapDropsOldestSegment) {
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", SEGMENT));  // deux segments en rotation
+    push(store, 0, 3 * SEGMENT + 8);
+    EXPECT_EQ(store.dropped(), 2 * SEGMENT);
+    EXPECT_EQ(store.pending(), SEGMENT + 8);
+    EXPECT_FALSE(LittleFS.exists("/tlm2.bin"));
+    EXPECT_EQ(drain(store).front().seq, 2 * SEGMENT);
+
+    // La rotation survit au redémarrage
+    TelemetryStore reloaded;
+    ASSERT_TRUE(reloaded.begin("/tlm", SEGMENT));
+    EXPECT_EQ(reloaded.pending(), SEGMENT + 8);
+    std::vector<TelemetryRecord> all = drain(reloaded, 2 * SEGMENT);
+    ASSERT_EQ(all.size(), SEGMENT + 8);
+    EXPECT_EQ(all.front().ts, 1750000000 + 2 * SEGMENT);
+    EXPECT_EQ(all.back().ts, 1750000000 + 3 * SEGMENT + 7);
+}
+
+TEST_F(TelemetryStoreTest, CorruptRecordIsSkipped) {
+    {
+        TelemetryStore store;
+        ASSERT_TRUE(store.begin("/tlm", 64));
+        push(store, 0, 16);
+    }
+    corrupt("/tlm0.bin", 3 * sizeof(TelemetryRecord) + 5);  // échantillon 3
+    corrupt("/tlm0.bin", 0);                                // échantillon 0
+
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", 64));
+    std::vector<TelemetryRecord> all = drain(store);
+    ASSERT_EQ(all.size(), 14u);
+    EXPECT_EQ(all[0].seq, 1u);
+    EXPECT_EQ(all[1].seq, 2u);
+    EXPECT_EQ(all[2].seq, 4u);
+    EXPECT_EQ(store.pending(), 15u);  // l'échantillon 0, en tête, est abandonné
+}
+
+TEST_F(TelemetryStoreTest, TornTailIsOverwritten) {
+    {
+        TelemetryStore store;
+        ASSERT_TRUE(store.begin("/tlm", 64));
+        push(store, 0, 8);
+    }
+    // Coupure au milieu de l'écriture suivante : une moitié d'enregistrement
+    File f = LittleFS.open("/tlm0.bin", FILE_APPEND);
+    uint8_t half[sizeof(TelemetryRecord) / 2] = { 0xFF };
+    f.write(half, sizeof(half));
+    f.close();
+
+    TelemetryStore store;
+    ASSERT_TRUE(store.begin("/tlm", 64));
+    EXPECT_EQ(store.pending(), 8u);
+    push(store, 8, 8);
+    std::vector<TelemetryRecord> all = drain(store);
+    ASSERT_EQ(all.size(), 16u);
+    for (uint32_t i = 0; i < all.size(); i++) EXPECT_EQ(all[i].seq, i);
+    EXPECT_EQ(LittleFS.open("/tlm0.bin").size(), 16 * sizeof(TelemetryRecord));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,200 @@
+// Chemins chauds de main.cpp, appelés tels quels après un setup() réel (HAL
+// sans threads, sans sortie) : ce que coûte chaque poll hors réseau.
+#include <benchmark/benchmark.h>
+#include <ArduinoJson.h>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "hal_native.h"
+#include "json_arena.h"
+#include "telemetry_store.h"
+#include "window_rules.h"
+
+void setup();
+void addStats(JsonDocument& doc);
+void addSample(JsonArray samples, const TelemetryRecord& r);
+RuleAction decideAuto(RuleInputs& in, int* rule);
+extern JsonArena netArena;
+extern JsonDocument weatherFilter;
+extern volatile bool localOffsetKnown;
+extern bool statsDue;
+extern unsigned long lastStats;
+
+namespace {
+
+// Réponse de POST /api/window/log ou GET /api/window/command
+const char COMMAND_RESPONSE[] = "{\"success\":true,\"command\":\"OPEN\",\"position\":60,\"version\":1792142134123}";
+
+// Réponse Open-Meteo complète (tous les champs que les règles peuvent demander)
+const char WEATHER_BODY[] =
+    "{\"latitude\":45.18,\"longitude\":5.72,\"generationtime_ms\":0.05,\"utc_offset_seconds\":0,"
+    "\"timezone\":\"GMT\",\"timezone_abbreviation\":\"GMT\",\"elevation\":214.0,"
+    "\"current_units\":{\"time\":\"iso8601\",\"interval\":\"seconds\",\"temperature_2m\":\"°C\","
+    "\"european_aqi\":\"EAQI\",\"wind_speed_10m\":\"km/h\",\"precipitation\":\"mm\",\"relative_humidity_2m\":\"%\"},"
+    "\"current\":{\"time\":\"2025-06-01T12:00\",\"interval\":900,\"temperature_2m\":24.3,\"european_aqi\":31,"
+    "\"wind_speed_10m\":12.4,\"precipitation\":0.0,\"relative_humidity_2m\":58}}";
+
+const char* CHAR_CONFIG_UUID = "beb5483e-36e1-4688-b7f5-ea07361b26a8";
+
+// Un seul démarrage pour tout le programme
+void boot() {
+    static bool booted = false;
+    if (booted) return;
+    booted = true;
+    hal::begin();
+    hal::setQuiet(true);
+    hal::setThreads(false);
+    hal::nvsLoad("config.ssid=bench");
+    setup();
+}
+
+// Corps posté comme postDoc() : JSON (arg 0) ou MessagePack (arg 1)
+size_t encode(JsonDocument& doc, bool pack) {
+    size_t len = pack ? measureMsgPack(doc) : measureJson(doc);
+    char* body = (char*)netArena.allocate(len + 1);
+    if (pack) serializeMsgPack(doc, body, len);
+    else serializeJson(doc, body, len + 1);
+    benchmark::DoNotOptimize(body);
+    netArena.deallocate(body);
+    return len;
+}
+
+// Document du poll ; `stats` : compteurs dus (un envoi par STATS_MS) ou non
+void fillLog(JsonDocument& doc, bool stats) {
+    statsDue = stats;
+    lastStats = millis();
+    doc["temp"] = 24.3f;
+    doc["aqi"] = 31;
+    doc["isOpen"] = true;
+    doc["opening"] = 60;
+    doc["ts"] = 1792142134;
+    addStats(doc);
+}
+
+// Document du poll (checkSystem()) sérialisé dans l'arène : échantillon seul,
+// cas de presque tous les polls
+void BM_LogSerialize(benchmark::State& state) {
+    boot();
+    bool pack = state.range(0) != 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        {
+            JsonDocument doc(&netArena);
+            fillLog(doc, false);
+            bytes = encode(doc, pack);
+        }
+        netArena.reset();
+    }
+    state.counters["bytes"] = bytes;
+}
+BENCHMARK(BM_LogSerialize)->Arg(0)->Arg(1);
+
+// Le même document quand les compteurs sont dus (un envoi par STATS_MS)
+void BM_StatsSerialize(benchmark::State& state) {
+    boot();
+    bool pack = state.range(0) != 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        {
+            JsonDocument doc(&netArena);
+            fillLog(doc, true);
+            bytes = encode(doc, pack);
+        }
+        netArena.reset();
+    }
+    state.counters["bytes"] = bytes;
+}
+BENCHMARK(BM_StatsSerialize)->Arg(0)->Arg(1);
+
+// Lot de rattrapage complet (TELEMETRY_BATCH échantillons) : là où le format pèse le plus
+const int BATCH = 32;
+void BM_BatchSerialize(benchmark::State& state) {
+    boot();
+    bool pack = state.range(0) != 0;
+    TelemetryRecord records[BATCH];
+    for (int i = 0; i < BATCH; i++) records[i] = { (uint32_t)i, 1792142134u + 2 * i, (int16_t)(243 + i % 5), (uint16_t)(31 + i % 3), (uint8_t)(i > 20), 0, 0 };
+    size_t bytes = 0;
+    for (auto _ : state) {
+        {
+            JsonDocument doc(&netArena);
+            JsonArray samples = doc["samples"].to<JsonArray>();
+            for (const TelemetryRecord& r : records) addSample(samples, r);
+            bytes = encode(doc, pack);
+        }
+        netArena.reset();
+    }
+    state.counters["bytes"] = bytes;
+}
+BENCHMARK(BM_BatchSerialize)->Arg(0)->Arg(1);
+
+// Lecture de l'ordre dans la réponse du backend (readCommand()), JSON (arg 0)
+// ou MessagePack (arg 1, même contenu réencodé)
+void BM_CommandDeserialize(benchmark::State& state) {
+    boot();
+    std::string body = COMMAND_RESPONSE;
+    if (state.range(0)) {
+        JsonDocument doc;
+        deserializeJson(doc, COMMAND_RESPONSE);
+        body.resize(measureMsgPack(doc));
+        serializeMsgPack(doc, &body[0], body.size());
+    }
+    for (auto _ : state) {
+        {
+            JsonDocument doc(&netArena);
+            if (state.range(0)) deserializeMsgPack(doc, body.data(), body.size());
+            else deserializeJson(doc, body.data(), body.size());
+            benchmark::DoNotOptimize(doc["command"] | "AUTO");
+            benchmark::DoNotOptimize(doc["position"] | 100);
+            benchmark::DoNotOptimize(doc["version"] | (uint64_t)0);
+        }
+        netArena.reset();
+    }
+    state.counters["bytes"] = body.size();
+}
+BENCHMARK(BM_CommandDeserialize)->Arg(0)->Arg(1);
+
+// Corps Open-Meteo, avec le filtre de WeatherClient (arg 1) ou complet, comme
+// avant le parsing en flux (arg 0)
+void BM_WeatherDeserialize(benchmark::State& state) {
+    boot();
+    bool filtered = state.range(0) != 0;
+    for (auto _ : state) {
+        {
+            JsonDocument doc(&netArena);
+            if (filtered) deserializeJson(doc, WEATHER_BODY, DeserializationOption::Filter(weatherFilter));
+            else deserializeJson(doc, WEATHER_BODY);
+            benchmark::DoNotOptimize(doc["current"]["temperature_2m"].as<float>());
+            benchmark::DoNotOptimize(doc["current"]["european_aqi"] | 20);
+        }
+        netArena.reset();
+    }
+    state.counters["bytes"] = sizeof(WEATHER_BODY) - 1;
+}
+BENCHMARK(BM_WeatherDeserialize)->Arg(0)->Arg(1);
+
+// Décision AUTO complète (heure locale, verrou, règles par défaut)
+void BM_AutoDecision(benchmark::State& state) {
+    boot();
+    localOffsetKnown = true; // heure locale connue, comme après la première météo
+    RuleInputs in = { { 24.3f, 31, 12.4f, 0.0f, 58, NAN } };
+    int rule;
+    for (auto _ : state) {
+        in.v[RULE_TEMP] = in.v[RULE_TEMP] > 35 ? 20.0f : in.v[RULE_TEMP] + 0.7f;
+        benchmark::DoNotOptimize(decideAuto(in, &rule));
+    }
+}
+BENCHMARK(BM_AutoDecision);
+
+// Écriture BLE "ssid;pass;lat;lon" jusqu'à la boîte aux lettres de loop()
+// (ConfigCallbacks::onWrite(), copie de la valeur par la pile BLE comprise)
+void BM_BleConfigWrite(benchmark::State& state) {
+    boot();
+    std::string value = "Livebox-4F2A;correct horse battery staple;45.1885;5.7245";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hal::bleWrite(CHAR_CONFIG_UUID, value));
+    }
+}
+BENCHMARK(BM_BleConfigWrite);
+
+}  // namespace
@@ -0,0 +1,11 @@
+// Micro-benchmarks des chemins chauds du firmware, sur l'hôte :
+//
+//   bench_rules.cpp     évaluation et compilation des règles du mode AUTO
+//   bench_firmware.cpp  document de log, réponses backend et Open-Meteo,
+//                       décision AUTO, écriture BLE de configuration
+//
+//   pio run -e bench && .pio/build/bench/program
+//   python3 tools/bench/record.py   (résultats par commit, voir README)
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+// Coût d'évaluation des règles du mode AUTO selon la taille de l'ensemble,
+// comparé au seuil câblé d'avant (temp > 30 || aqi > 50).
+//
+//   pio run -e bench && .pio/build/bench/program --benchmark_filter=Rules
+//
+// Les entrées sont tirées à l'avance (météo d'été, une heure sur quatre sans
+// vent ni pluie connus) pour que chaque itération parcoure d'autres branches.
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "window_rules.h"
+
+namespace {
+
+const size_t INPUTS = 1024;
+
+std::vector<RuleInputs> inputs() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> temp(10, 38), aqi(5, 90), wind(0, 60), rain(0, 3), humidity(20, 100),
+        hour(0, 24);
+    std::vector<RuleInputs> in(INPUTS);
+    for (size_t i = 0; i < INPUTS; i++) {
+        bool unknown = i % 4 == 0;
+        in[i] = { { temp(rng), aqi(rng), unknown ? NAN : wind(rng), unknown ? NAN : rain(rng), humidity(rng),
+                    hour(rng) } };
+    }
+    return in;
+}
+
+// `n` règles de deux conditions chacune sur des grandeurs et seuils variés,
+// plus la règle par défaut : le pire cas parcourt toute la table.
+std::string ruleText(int n) {
+    static const char* vars[] = { "temp", "aqi", "wind", "rain", "humidity", "hour" };
+    static const char* ops[] = { ">", ">=", "<", "<=" };
+    std::string text;
+    for (int r = 0; r < n; r++) {
+        char rule[96];
+        snprintf(rule, sizeof(rule), "%s%s%d&%s%s%d:%s;", vars[r % 6], ops[r % 4], 20 + 3 * r,
+                 vars[(r + 2) % 6], ops[(r + 1) % 4], 5 + 2 * r, r % 2 ? "OPEN" : "CLOSE");
+        text += rule;
+    }
+    return text + "*:HOLD";
+}
+
+void BM_RulesEvaluate(benchmark::State& state) {
+    RuleSet rules;
+    std::string text = ruleText(state.range(0));
+    if (!rules.compile(text.c_str())) {
+        state.SkipWithError("règles invalides");
+        return;
+    }
+    std::vector<RuleInputs> in = inputs();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rules.evaluate(in[i++ % INPUTS]));
+    }
+    state.counters["conditions"] = rules.conditions();
+    state.counters["terms"] = rules.terms();
+}
+BENCHMARK(BM_RulesEvaluate)->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(15);
+
+void BM_RulesDefault(benchmark::State& state) {
+    RuleSet rules;
+    rules.compile(RuleSet::DEFAULT_RULES);
+    std::vector<RuleInputs> in = inputs();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rules.evaluate(in[i++ % INPUTS]));
+    }
+}
+BENCHMARK(BM_RulesDefault);
+
+// Référence : l'ancienne décision câblée dans applyCommand()
+void BM_RulesHardcoded(benchmark::State& state) {
+    std::vector<RuleInputs> in = inputs();
+    size_t i = 0;
+    for (auto _ : state) {
+        const RuleInputs& x = in[i++ % INPUTS];
+        benchmark::DoNotOptimize(x.v[RULE_TEMP] > 30.0 || x.v[RULE_AQI] > 50 ? RULE_CLOSE : RULE_OPEN);
+    }
+}
+BENCHMARK(BM_RulesHardcoded);
+
+// Compilation (écriture BLE ou démarrage) : hors du chemin chaud
+void BM_RulesCompile(benchmark::State& state) {
+    std::string text = ruleText(state.range(0));
+    RuleSet rules;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rules.compile(text.c_str()));
+    }
+}
+BENCHMARK(BM_RulesCompile)->Arg(1)->Arg(15);
+
+}  // namespace
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Lance les micro-benchmarks et garde le résultat du commit courant.
+
+    python3 tools/bench/record.py [--program PROG] [--threshold PCT] [-- args du bench]
+
+Le résultat (JSON de Google Benchmark, médiane de 5 répétitions) va dans
+tools/bench/results/<commit>.json (<commit>-dirty.json si l'arbre est
+modifié), puis est comparé au dernier commit ancêtre qui a un résultat : un
+benchmark plus lent de plus de PCT % (10 par défaut) est signalé et le code de
+sortie vaut 1. La comparaison est refusée (code 0) si les deux résultats ne
+viennent pas du même hôte, du même type de build de la bibliothèque, ou d'une
+machine au repos. À lancer depuis firmware/, après `pio run -e bench`.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+RESULTS = os.path.join(HERE, "results")
+
+
+def git(*args):
+    return subprocess.run(["git", *args], cwd=HERE, check=True, capture_output=True, text=True).stdout.strip()
+
+
+def medians(path):
+    with open(path) as f:
+        data = json.load(f)
+    out = {}
+    for b in data["benchmarks"]:
+        if b.get("aggregate_name") == "median":
+            out[b["run_name"]] = b["cpu_time"] * {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}[b["time_unit"]]
+    return data["context"], out
+
+
+def not_comparable(context, base_context):
+    """Raison de ne pas comparer deux résultats, None s'ils se comparent."""
+    for key in ("host_name", "library_build_type", "num_cpus", "mhz_per_cpu"):
+        if context.get(key) != base_context.get(key):
+            return "%s différent (%s, puis %s)" % (key, base_context.get(key), context.get(key))
+    if context.get("library_build_type") != "release":
+        return "bibliothèque de benchmark en build %s" % context.get("library_build_type")
+    for which, ctx in (("la référence", base_context), ("ce résultat", context)):
+        load = (ctx.get("load_avg") or [0])[0]
+        if load > 0.5 * ctx.get("num_cpus", 1):
+            return "machine chargée pendant %s (charge %.1f pour %d CPU)" % (which, load, ctx.get("num_cpus", 1))
+    return None
+
+
+def previous_result():
+    for commit in git("rev-list", "--first-parent", "--max-count=200", "HEAD~1").split():
+        path = os.path.join(RESULTS, commit[:12] + ".json")
+        if os.path.exists(path):
+            return commit[:12], path
+    return None, None
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--program", default=".pio/build/bench/program")
+    parser.add_argument("--threshold", type=float, default=10.0)
+    parser.add_argument("extra", nargs="*")
+    args = parser.parse_args()
+
+    commit = git("rev-parse", "--short=12", "HEAD")
+    if git("status", "--porcelain", "--untracked-files=no", "--", "../.."):
+        commit += "-dirty"
+    os.makedirs(RESULTS, exist_ok=True)
+    out = os.path.join(RESULTS, commit + ".json")
+    subprocess.run([args.program, "--benchmark_repetitions=5", "--benchmark_report_aggregates_only=true",
+                    "--benchmark_out=" + out, "--benchmark_out_format=json", *args.extra], check=True)
+    print("résultat : " + os.path.relpath(out))
+
+    base, base_path = previous_result()
+    if not base:
+        print("aucun résultat plus ancien à comparer")
+        return 0
+    context, now = medians(out)
+    base_context, before = medians(base_path)
+    reason = not_comparable(context, base_context)
+    if reason:
+        print("comparaison avec %s ignorée : %s" % (base, reason))
+        return 0
+
+    print("\n%-40s %12s %12s %8s" % ("comparé à " + base, "avant (ns)", "après (ns)", "écart"))
+    regressions = 0
+    for name, t in now.items():
+        if name not in before:
+            print("%-40s %12s %12.1f %8s" % (name, "-", t, "nouveau"))
+            continue
+        delta = 100.0 * (t - before[name]) / before[name]
+        flag = ""
+        if delta > args.threshold:
+            flag = "  RÉGRESSION"
+            regressions += 1
+        print("%-40s %12.1f %12.1f %+7.1f%%%s" % (name, before[name], t, delta, flag))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
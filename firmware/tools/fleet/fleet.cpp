@@ -0,0 +1,660 @@
+// Banc de charge d'une flotte de fenêtres : N processus du firmware natif
+// (setup()/loop() réels, tâches réseau et push comprises) parlent en TCP à un
+// backend local qui implémente le contrat de backend/src/server.js
+// (/api/window/log, /log/batch, /command avec long-poll), sans réseau extérieur.
+//
+// Le backend change d'ordre toutes les --command-every secondes (CLOSE, OPEN,
+// CLOSE...) ; chaque instance connaît ce calendrier et mesure le délai entre
+// le changement et le départ du servo vers la bonne butée.
+//
+//   pio run -e fleet
+//   .pio/build/fleet/program --devices 1000 --duration 120 --period 2000 --jitter 0.2
+//   .pio/build/fleet/program --devices 300 --drop 0.02 --errors 0.05 --delay 150
+//   .pio/build/fleet/program --devices 50 --backend 127.0.0.1:3001   # backend Node local
+//   .pio/build/fleet/program --devices 500 --budget 100   # cadence dictée par le backend (nextPollMs)
+//   .pio/build/fleet/program --devices 300 --power-cut --jitter 0 --nvs config.jitter=0   # grille fixe
+//
+// Rapport : requêtes/s (moyenne et pic côté backend) et courbe du débit
+// lissé, taux d'échecs réseau et d'erreurs HTTP vus par les instances,
+// percentiles du délai de propagation.
+#include <Arduino.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <queue>
+#include <random>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "hal_native.h"
+#include "power.h"
+
+void setup();
+void loop();
+extern PowerManager power;
+
+namespace {
+
+struct Config {
+    uint32_t devices = 100;
+    uint32_t durationS = 60;
+    uint32_t periodMs = 2000;
+    float jitter = 0.1f;          // période de chaque instance tirée dans ±jitter
+    bool powerCut = false;        // toutes les instances démarrent au même instant
+    uint32_t smoothS = 5;         // fenêtre de la moyenne glissante du débit
+    uint32_t commandEveryS = 10;
+    float drop = 0;               // part des requêtes coupées sans réponse
+    float errors = 0;             // part des requêtes en 503
+    uint32_t delayMs = 0;         // latence ajoutée à chaque réponse
+    bool noPush = false;          // backend sans long-poll (ancien contrat)
+    float budget = 0;             // req/s visées par le backend (nextPollMs, retryAfter), 0 : sans
+    uint16_t port = 4001;
+    std::string backend;          // "hote:port" : backend externe au lieu du banc
+    std::string nvs;              // clés NVS en plus pour chaque instance
+    uint32_t seed = 1;
+};
+
+const uint32_t MAX_CHANGES = 512;
+
+// Résultat d'une instance, écrit dans une zone partagée avant sa sortie.
+struct DeviceResult {
+    uint64_t requests;
+    uint64_t failures;
+    uint64_t errors;
+    uint32_t changes;             // changements d'ordre échus pendant la mesure
+    uint32_t applied;
+    uint16_t awakePermille;       // part du temps CPU éveillé (PowerManager, 1000 hors light-sleep)
+    uint32_t latencyMs[MAX_CHANGES];
+    bool done;
+};
+
+uint64_t nowMs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void sleepUntil(uint64_t ms) {
+    for (uint64_t now = nowMs(); now < ms; now = nowMs()) usleep((useconds_t)std::min<uint64_t>(ms - now, 100) * 1000);
+}
+
+// --- Instance -------------------------------------------------------------------
+
+// Ordre k (k >= 1) du calendrier : impair CLOSE (servo à 0), pair OPEN (90).
+int expectedAngle(uint32_t k) {
+    return k % 2 ? 0 : 90;
+}
+
+[[noreturn]] void runDevice(const Config& cfg, uint32_t index, uint64_t t0, DeviceResult* out) {
+    std::mt19937 rng(cfg.seed * 7919 + index);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    uint32_t period = (uint32_t)(cfg.periodMs * (1.0f + cfg.jitter * (2.0f * unit(rng) - 1.0f)));
+    uint64_t spread = (uint64_t)(unit(rng) * cfg.periodMs);
+    uint64_t boot = cfg.powerCut ? t0 : t0 + spread;
+
+    char mac[32];
+    snprintf(mac, sizeof(mac), "02:00:00:%02x:%02x:%02x", (index >> 16) & 0xFF, (index >> 8) & 0xFF, index & 0xFF);
+    setenv("HAL_MAC", mac, 1);
+    hal::begin();
+    hal::setQuiet(true);
+    hal::setThreads(true);
+    hal::redirect("*", 3001, cfg.backend);
+    std::string nvs = "config.ssid=fleet,config.pollMs=" + std::to_string(period);
+    if (!cfg.nvs.empty()) nvs += "," + cfg.nvs;
+    hal::nvsLoad(nvs);
+
+    sleepUntil(boot);
+    setup();
+    uint64_t end = t0 + cfg.durationS * 1000ULL;
+    uint64_t every = cfg.commandEveryS * 1000ULL;
+    // Changements comptés : ceux suivis d'une période entière avant la fin de la mesure
+    uint64_t span = end - t0;
+    out->changes = (uint32_t)std::min<uint64_t>(span >= every ? span / every - 1 : 0, MAX_CHANGES);
+    // loop() dort jusqu'à son prochain événement : le servo est observé à côté,
+    // toutes les 5 ms, et la mesure s'arrête à l'heure même si loop() dort encore
+    std::thread([] {
+        for (;;) {
+            try {
+                loop();
+            } catch (const hal::Restart&) {
+                setup();
+            }
+        }
+    }).detach();
+    uint32_t lastApplied = 0;
+    int lastAngle = -1;
+    for (uint64_t now = nowMs(); now < end; now = nowMs()) {
+        usleep(5000);
+        now = nowMs();
+        uint32_t k = now > t0 ? (uint32_t)((now - t0) / every) : 0;
+        // Appliqué dès que le servo part vers la bonne butée (la course elle-même dure ~1,5 s)
+        int angle = hal::stats().servoAngle;
+        int expected = expectedAngle(k);
+        bool toward = angle == expected || (lastAngle >= 0 && (expected > 0 ? angle > lastAngle : angle < lastAngle));
+        if (k >= 1 && k > lastApplied && k <= out->changes && toward) {
+            out->latencyMs[out->applied++] = (uint32_t)(now - (t0 + k * every));
+            lastApplied = k;
+        }
+        lastAngle = angle;
+    }
+
+    const hal::Stats& stats = hal::stats();
+    out->requests = stats.httpRequests;
+    out->failures = stats.httpFailures;
+    out->errors = stats.httpErrors;
+    out->awakePermille = power.awakePermille();
+    out->done = true;
+    _exit(0);  // les tâches réseau tournent encore : pas de destructeurs
+}
+
+// --- Backend local (epoll) --------------------------------------------------------
+
+class Backend {
+public:
+    Backend(const Config& cfg) : _cfg(cfg), _rng(cfg.seed), _pollMs(cfg.periodMs) {}
+
+    bool listen() {
+        _listen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_cfg.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(_listen, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(_listen, 4096) < 0) {
+            fprintf(stderr, "fleet: port %u indisponible (%s)\n", _cfg.port, strerror(errno));
+            return false;
+        }
+        _epoll = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = _listen;
+        epoll_ctl(_epoll, EPOLL_CTL_ADD, _listen, &ev);
+        return true;
+    }
+
+    // Sert jusqu'à `until` ; les changements d'ordre suivent le calendrier à partir de t0.
+    void run(uint64_t t0, uint64_t until) {
+        _t0 = t0;
+        _version = t0;
+        uint64_t every = _cfg.commandEveryS * 1000ULL;
+        uint32_t k = 0;
+        epoll_event events[256];
+        for (uint64_t now = nowMs(); now < until; now = nowMs()) {
+            uint64_t next = std::min(until, t0 + (k + 1) * every);
+            if (!_delayed.empty()) next = std::min(next, _delayed.top().at);
+            for (const auto& c : _clients) {
+                if (c.second.parked) next = std::min(next, c.second.parkedUntil);
+            }
+            int timeout = next > now ? (int)std::min<uint64_t>(next - now, 1000) : 0;
+            int n = epoll_wait(_epoll, events, 256, timeout);
+            for (int i = 0; i < n; i++) {
+                if (events[i].data.fd == _listen) accept();
+                else handle(events[i].data.fd, events[i].events);
+            }
+
+            now = nowMs();
+            bool changed = now >= t0 + (k + 1) * every;
+            if (changed) {
+                k++;
+                _command = k % 2 ? "CLOSE" : "OPEN";
+                _version = t0 + k * every;  // comme server.js : version = date du changement (ms)
+            }
+            std::vector<int> wake;
+            for (const auto& c : _clients) {
+                if (c.second.parked && (changed || now >= c.second.parkedUntil)) wake.push_back(c.first);
+            }
+            for (int fd : wake) answerCommand(fd);
+            while (!_delayed.empty() && _delayed.top().at <= now) {
+                Delayed d = _delayed.top();
+                _delayed.pop();
+                auto it = _clients.find(d.fd);
+                if (it != _clients.end() && it->second.generation == d.generation) write(d.fd, d.response);
+            }
+        }
+    }
+
+    void sizeTimeline(uint32_t seconds) { _perSecond.assign(seconds, 0); }
+    uint64_t requests() const { return _requests; }
+    uint64_t dropped() const { return _dropped; }
+    uint64_t failed() const { return _failed; }
+    const std::vector<uint32_t>& perSecond() const { return _perSecond; }
+    uint32_t peakPerSecond() const {
+        uint32_t peak = 0;
+        for (uint32_t v : _perSecond) peak = std::max(peak, v);
+        return peak;
+    }
+    size_t maxClients() const { return _maxClients; }
+    uint32_t pollMs() const { return _pollMs; }
+    uint32_t maxPollMs() const { return _maxPollMs; }
+    uint64_t retries() const { return _retries; }
+
+private:
+    struct Client {
+        std::string in;
+        std::string out;
+        bool parked = false;
+        uint64_t parkedUntil = 0;
+        uint64_t generation = 0;
+    };
+    struct Delayed {
+        uint64_t at;
+        int fd;
+        uint64_t generation;
+        std::string response;
+        bool operator<(const Delayed& o) const { return at > o.at; }
+    };
+
+    void accept() {
+        for (;;) {
+            int fd = accept4(_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev);
+            Client& c = _clients[fd];
+            c = Client();
+            c.generation = ++_generation;
+            _maxClients = std::max(_maxClients, _clients.size());
+        }
+    }
+
+    void close(int fd) {
+        epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        _clients.erase(fd);
+    }
+
+    void handle(int fd, uint32_t events) {
+        auto it = _clients.find(fd);
+        if (it == _clients.end()) return;
+        if (events & EPOLLOUT) {
+            flush(fd);
+            it = _clients.find(fd);
+            if (it == _clients.end()) return;
+        }
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            char buf[4096];
+            for (;;) {
+                ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n > 0) { it->second.in.append(buf, n); continue; }
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) { close(fd); return; }
+                break;
+            }
+            serve(fd);
+        }
+    }
+
+    // Traite les requêtes complètes du tampon (une à la fois si un long-poll est en attente).
+    void serve(int fd) {
+        for (;;) {
+            auto it = _clients.find(fd);
+            if (it == _clients.end() || it->second.parked) return;
+            Client& c = it->second;
+            size_t headerEnd = c.in.find("\r\n\r\n");
+            if (headerEnd == std::string::npos) return;
+            size_t length = 0;
+            const char* cl = strcasestr(c.in.c_str(), "\r\nContent-Length:");
+            if (cl && (size_t)(cl - c.in.c_str()) < headerEnd) length = strtoul(cl + 17, nullptr, 10);
+            if (c.in.size() < headerEnd + 4 + length) return;
+            std::string head = c.in.substr(0, headerEnd);
+            std::string body = c.in.substr(headerEnd + 4, length);
+            c.in.erase(0, headerEnd + 4 + length);
+            route(fd, head, body);
+        }
+    }
+
+    void route(int fd, const std::string& head, const std::string& body) {
+        _requests++;
+        uint64_t now = nowMs();
+        if (now >= _t0 && (now - _t0) / 1000 < _perSecond.size()) _perSecond[(now - _t0) / 1000]++;
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        if (_cfg.drop > 0 && unit(_rng) < _cfg.drop) {
+            _dropped++;
+            close(fd);
+            return;
+        }
+        if (_cfg.errors > 0 && unit(_rng) < _cfg.errors) {
+            _failed++;
+            reply(fd, 503, "{\"error\":\"injected\"}");
+            return;
+        }
+
+        size_t sp = head.find(' ');
+        std::string method = head.substr(0, sp);
+        std::string path = head.substr(sp + 1, head.find(' ', sp + 1) - sp - 1);
+        // Les long-polls suivent les changements d'ordre, pas la période de poll
+        if (_cfg.budget > 0 && query(path, "wait").empty()) pace(now);
+        if (method == "POST" && path == "/api/window/log") {
+            reply(fd, 200, "{\"success\":true," + commandFields() + "}");
+        } else if (method == "POST" && path == "/api/window/log/batch") {
+            size_t stored = 0;
+            for (size_t p = body.find("\"isOpen\""); p != std::string::npos; p = body.find("\"isOpen\"", p + 1)) stored++;
+            reply(fd, 200, "{\"success\":true,\"stored\":" + std::to_string(stored) + "," + commandFields() + "}");
+        } else if (method == "GET" && path.rfind("/api/window/command", 0) == 0) {
+            std::string since = query(path, "since");
+            long wait = atol(query(path, "wait").c_str());
+            if (!since.empty() && wait > 0) {
+                if (_cfg.noPush) { reply(fd, 404, "{}"); return; }
+                if (strtoull(since.c_str(), nullptr, 10) == _version) {
+                    Client& c = _clients[fd];
+                    c.parked = true;
+                    c.parkedUntil = nowMs() + std::min(wait, 55L) * 1000;
+                    return;
+                }
+            }
+            reply(fd, 200, "{" + commandFields() + "}");
+        } else {
+            reply(fd, 404, "{}");
+        }
+    }
+
+    void answerCommand(int fd) {
+        auto it = _clients.find(fd);
+        if (it == _clients.end()) return;
+        it->second.parked = false;
+        reply(fd, 200, "{" + commandFields() + "}", false);
+        serve(fd);
+    }
+
+    // Même régulation que server.js : par fenêtres de 10 s, période corrigée en
+    // proportion de la charge des polls sur le budget, jamais sous la période de base.
+    void pace(uint64_t now) {
+        _windowCount++;
+        if (_windowStart == 0) _windowStart = now;
+        if (now - _windowStart < 10000) return;
+        _loadRate = _windowCount * 1000.0 / (now - _windowStart);
+        _pollMs = (uint32_t)std::min(60000.0, std::max((double)_cfg.periodMs, _pollMs * _loadRate / _cfg.budget));
+        _windowStart = now;
+        _windowCount = 0;
+        _maxPollMs = std::max(_maxPollMs, _pollMs);
+    }
+
+    std::string commandFields() {
+        std::string fields = "\"command\":\"" + _command + "\",\"version\":" + std::to_string(_version);
+        if (_cfg.budget <= 0 || _pollMs <= _cfg.periodMs) return fields;
+        fields += ",\"nextPollMs\":" + std::to_string(_pollMs);
+        if (_loadRate > 2 * _cfg.budget) {
+            std::uniform_int_distribution<uint32_t> spread(1, (_pollMs + 999) / 1000);
+            fields += ",\"retryAfter\":" + std::to_string(spread(_rng));
+            _retries++;
+        }
+        return fields;
+    }
+
+    static std::string query(const std::string& path, const std::string& key) {
+        size_t q = path.find('?');
+        while (q != std::string::npos) {
+            size_t end = path.find('&', q + 1);
+            std::string item = path.substr(q + 1, end == std::string::npos ? std::string::npos : end - q - 1);
+            if (item.compare(0, key.size() + 1, key + "=") == 0) return item.substr(key.size() + 1);
+            q = end;
+        }
+        return "";
+    }
+
+    // `delayed` : la latence injectée ne s'applique pas à la fin d'un long-poll
+    void reply(int fd, int status, const std::string& body, bool delayed = true) {
+        const char* reason = status == 200 ? "OK" : status == 404 ? "Not Found" : "Service Unavailable";
+        std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason +
+                               "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+                               "\r\nConnection: keep-alive\r\n\r\n" + body;
+        if (delayed && _cfg.delayMs > 0) {
+            _delayed.push({nowMs() + _cfg.delayMs, fd, _clients[fd].generation, response});
+            return;
+        }
+        write(fd, response);
+    }
+
+    void write(int fd, const std::string& data) {
+        auto it = _clients.find(fd);
+        if (it == _clients.end()) return;
+        it->second.out += data;
+        flush(fd);
+    }
+
+    void flush(int fd) {
+        auto it = _clients.find(fd);
+        if (it == _clients.end()) return;
+        std::string& out = it->second.out;
+        while (!out.empty()) {
+            ssize_t n = send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+            if (n > 0) { out.erase(0, n); continue; }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            close(fd);
+            return;
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP | (out.empty() ? 0u : (uint32_t)EPOLLOUT);
+        ev.data.fd = fd;
+        epoll_ctl(_epoll, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    const Config& _cfg;
+    std::mt19937 _rng;
+    int _listen = -1;
+    int _epoll = -1;
+    std::map<int, Client> _clients;
+    std::priority_queue<Delayed> _delayed;
+    std::string _command = "AUTO";
+    uint64_t _version = 0;
+    uint64_t _generation = 0;
+    uint64_t _requests = 0, _dropped = 0, _failed = 0;
+    uint64_t _t0 = 0;
+    std::vector<uint32_t> _perSecond;
+    size_t _maxClients = 0;
+    uint64_t _windowStart = 0;
+    uint32_t _windowCount = 0;
+    double _loadRate = 0;
+    uint32_t _pollMs = 0;
+    uint32_t _maxPollMs = 0;
+    uint64_t _retries = 0;
+};
+
+// Backend externe : le calendrier d'ordres passe par POST /api/window/control.
+void postControl(const std::string& backend, const char* action) {
+    size_t colon = backend.rfind(':');
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)atoi(backend.c_str() + colon + 1));
+    inet_pton(AF_INET, backend.substr(0, colon).c_str(), &addr.sin_addr);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        std::string body = std::string("{\"action\":\"") + action + "\"}";
+        std::string req = "POST /api/window/control HTTP/1.1\r\nHost: " + backend +
+                          "\r\nContent-Type: application/json\r\nConnection: close\r\nContent-Length: " +
+                          std::to_string(body.size()) + "\r\n\r\n" + body;
+        send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+        char buf[512];
+        while (recv(fd, buf, sizeof(buf), 0) > 0) {}
+    } else {
+        fprintf(stderr, "fleet: backend %s injoignable pour /control\n", backend.c_str());
+    }
+    close(fd);
+}
+
+// Débit côté backend en moyenne glissante sur `window` secondes, une ligne par
+// pas (30 lignes au plus, le maximum du pas pour ne pas sauter les pics) : un
+// démarrage en bloc donne des pics périodiques, une flotte étalée une courbe plate.
+void printRateCurve(const std::vector<uint32_t>& perSecond, uint32_t window) {
+    if (perSecond.empty()) return;
+    window = std::max<uint32_t>(1, window);
+    std::vector<double> smooth(perSecond.size());
+    double sum = 0, peak = 0, total = 0;
+    for (size_t t = 0; t < perSecond.size(); t++) {
+        sum += perSecond[t];
+        if (t >= window) sum -= perSecond[t - window];
+        smooth[t] = sum / std::min<size_t>(t + 1, window);
+        peak = std::max(peak, smooth[t]);
+        total += perSecond[t];
+    }
+    double mean = total / perSecond.size();
+    printf("débit lissé sur %u s : moyenne %.1f req/s, pic %.1f req/s (%.2f × la moyenne)\n", window, mean, peak,
+           mean > 0 ? peak / mean : 0.0);
+    size_t step = std::max<size_t>(1, (perSecond.size() + 29) / 30);
+    for (size_t t = 0; t < perSecond.size(); t += step) {
+        double top = *std::max_element(smooth.begin() + t, smooth.begin() + std::min(t + step, smooth.size()));
+        int bar = peak > 0 ? (int)(50 * top / peak + 0.5) : 0;
+        printf("  %5zu s %7.1f %s\n", t, top, std::string(bar, '#').c_str());
+    }
+}
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [--devices N] [--duration S] [--period MS] [--jitter F] [--command-every S]\n"
+            "          [--drop P] [--errors P] [--delay MS] [--no-push] [--port P] [--backend HOTE:PORT]\n"
+            "          [--nvs config.cle=val,...] [--budget REQ_S] [--power-cut] [--smooth S] [--seed S]\n",
+            argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config cfg;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (a == "--no-push") { cfg.noPush = true; continue; }
+        if (a == "--power-cut") { cfg.powerCut = true; continue; }
+        if (!v) { usage(argv[0]); return 2; }
+        i++;
+        if (a == "--devices") cfg.devices = strtoul(v, nullptr, 10);
+        else if (a == "--duration") cfg.durationS = strtoul(v, nullptr, 10);
+        else if (a == "--period") cfg.periodMs = strtoul(v, nullptr, 10);
+        else if (a == "--jitter") cfg.jitter = strtof(v, nullptr);
+        else if (a == "--command-every") cfg.commandEveryS = std::max(1UL, strtoul(v, nullptr, 10));
+        else if (a == "--drop") cfg.drop = strtof(v, nullptr);
+        else if (a == "--errors") cfg.errors = strtof(v, nullptr);
+        else if (a == "--delay") cfg.delayMs = strtoul(v, nullptr, 10);
+        else if (a == "--port") cfg.port = (uint16_t)strtoul(v, nullptr, 10);
+        else if (a == "--backend") cfg.backend = v;
+        else if (a == "--nvs") cfg.nvs = v;
+        else if (a == "--budget") cfg.budget = strtof(v, nullptr);
+        else if (a == "--smooth") cfg.smoothS = strtoul(v, nullptr, 10);
+        else if (a == "--seed") cfg.seed = strtoul(v, nullptr, 10);
+        else { usage(argv[0]); return 2; }
+    }
+    bool external = !cfg.backend.empty();
+    if (!external) cfg.backend = "127.0.0.1:" + std::to_string(cfg.port);
+
+    // Deux connexions par instance (poll + long-poll) côté backend
+    rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+        if (!external && lim.rlim_cur < 2 * cfg.devices + 64) {
+            fprintf(stderr, "fleet: %llu descripteurs max, %u instances risquent d'être refusées\n",
+                    (unsigned long long)lim.rlim_cur, cfg.devices);
+        }
+    }
+
+    Backend backend(cfg);
+    if (!external && !backend.listen()) return 1;
+    backend.sizeTimeline(cfg.durationS);
+
+    size_t bytes = sizeof(DeviceResult) * cfg.devices;
+    DeviceResult* results = (DeviceResult*)mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results == MAP_FAILED) {
+        perror("fleet: mmap");
+        return 1;
+    }
+    memset(results, 0, bytes);
+
+    // Toutes les instances démarrent dans la première période après t0 ; fork avant tout thread
+    uint64_t t0 = nowMs() + 1000 + cfg.devices / 2;
+    std::vector<pid_t> pids;
+    for (uint32_t i = 0; i < cfg.devices; i++) {
+        pid_t pid = fork();
+        if (pid == 0) runDevice(cfg, i, t0, &results[i]);
+        if (pid < 0) {
+            perror("fleet: fork");
+            break;
+        }
+        pids.push_back(pid);
+    }
+
+    uint64_t end = t0 + cfg.durationS * 1000ULL;
+    if (external) {
+        uint64_t every = cfg.commandEveryS * 1000ULL;
+        for (uint32_t k = 1; t0 + k * every < end; k++) {
+            sleepUntil(t0 + k * every);
+            postControl(cfg.backend, k % 2 ? "close" : "open");
+        }
+        sleepUntil(end + 2000);
+    } else {
+        backend.run(t0, end + 2000);
+    }
+    for (pid_t pid : pids) kill(pid, SIGKILL);  // retardataires (normalement tous sortis)
+    for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+
+    uint64_t requests = 0, failures = 0, errors = 0, changes = 0, applied = 0, awake = 0;
+    uint32_t finished = 0;
+    std::vector<uint32_t> latencies;
+    for (uint32_t i = 0; i < pids.size(); i++) {
+        const DeviceResult& r = results[i];
+        if (!r.done) continue;
+        finished++;
+        requests += r.requests;
+        failures += r.failures;
+        errors += r.errors;
+        changes += r.changes;
+        applied += r.applied;
+        awake += r.awakePermille;
+        latencies.insert(latencies.end(), r.latencyMs, r.latencyMs + r.applied);
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("fleet: %u instances (%u terminées), %u s, poll %u ms ±%.0f %%, ordre toutes les %u s%s%s\n", cfg.devices,
+           finished, cfg.durationS, cfg.periodMs, cfg.jitter * 100, cfg.commandEveryS, cfg.noPush ? ", sans push" : "",
+           cfg.powerCut ? ", démarrage simultané" : "");
+    if (cfg.drop > 0 || cfg.errors > 0 || cfg.delayMs > 0) {
+        printf("pannes injectées : %.1f %% coupées, %.1f %% en 503, +%u ms par réponse\n", cfg.drop * 100,
+               cfg.errors * 100, cfg.delayMs);
+    }
+    if (!external) {
+        printf("backend : %llu requêtes, %.1f req/s (pic %u req/s), %zu connexions simultanées max, "
+               "%llu coupées et %llu en 503 par injection\n",
+               (unsigned long long)backend.requests(), (double)backend.requests() / cfg.durationS,
+               backend.peakPerSecond(), backend.maxClients(), (unsigned long long)backend.dropped(),
+               (unsigned long long)backend.failed());
+        if (cfg.budget > 0) {
+            printf("régulation : budget %.0f req/s, période dictée %u ms en fin de mesure (max %u ms), %llu retryAfter\n",
+                   cfg.budget, backend.pollMs(), backend.maxPollMs(), (unsigned long long)backend.retries());
+        }
+        printRateCurve(backend.perSecond(), cfg.smoothS);
+    }
+    printf("instances : %llu requêtes (météo comprise), %.1f req/s, échecs réseau %.2f %%, erreurs HTTP %.2f %%, "
+           "CPU éveillé %.1f %% du temps\n",
+           (unsigned long long)requests, (double)requests / cfg.durationS,
+           requests ? 100.0 * failures / requests : 0.0, requests ? 100.0 * errors / requests : 0.0,
+           finished ? awake / 10.0 / finished : 0.0);
+    printf("propagation : %llu/%llu ordres appliqués (%.1f %%), p50 %u ms, p90 %u ms, p99 %u ms, max %u ms\n",
+           (unsigned long long)applied, (unsigned long long)changes, changes ? 100.0 * applied / changes : 0.0,
+           percentile(latencies, 0.50), percentile(latencies, 0.90), percentile(latencies, 0.99),
+           latencies.empty() ? 0 : latencies.back());
+    return 0;
+}
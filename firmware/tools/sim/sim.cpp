@@ -0,0 +1,267 @@
+// Simulation accélérée de la boucle de contrôle : le firmware tourne sur une
+// hal::SimClock, Open-Meteo est remplacé par une trace météo (export CSV
+// horaire d'Open-Meteo, ou trace synthétique) et chaque jour simulé est
+// résumé : requêtes, actionnements du servo, stabilité des décisions.
+//
+//   pio run -e sim
+//   .pio/build/sim/program                      # 7 jours synthétiques
+//   .pio/build/sim/program --days 28 --seed 3
+//   .pio/build/sim/program trace.csv --csv      # export Open-Meteo, sortie CSV
+//
+// Une bascule moins de 15 min après la précédente compte comme un battement.
+#include <Arduino.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hal_native.h"
+
+void setup();
+void loop();
+
+namespace {
+
+const uint32_t DAY_S = 86400;
+const uint32_t FLAP_S = 15 * 60;
+
+struct WeatherPoint {
+    uint32_t ts;
+    float temp;
+    int aqi;
+};
+
+// Lignes "2025-06-01T13:00,24.3,41" ; l'en-tête et les métadonnées de l'export sont ignorés.
+bool loadCsv(const char* path, std::vector<WeatherPoint>& trace) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        struct tm tm = {};
+        int aqi = 0;
+        float temp = 0;
+        if (sscanf(line, "%d-%d-%dT%d:%d,%f,%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+                   &temp, &aqi) != 7) continue;
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        trace.push_back({(uint32_t)timegm(&tm), temp, aqi});
+    }
+    fclose(f);
+    return trace.size() >= 2;
+}
+
+// Journées d'été : cycle diurne autour d'un niveau qui dérive d'un jour à
+// l'autre (certains après-midi passent 30 °C), AQI avec pointes du matin et du
+// soir autour de 50, bruit horaire.
+std::vector<WeatherPoint> synthetic(uint32_t days, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<WeatherPoint> trace;
+    uint32_t start = 1748736000;  // 2025-06-01T00:00Z
+    float level = 24.0f;
+    for (uint32_t h = 0; h <= days * 24; h++) {
+        if (h % 24 == 0) level = std::min(std::max(level + 2.0f * noise(rng), 18.0f), 28.0f);
+        float hour = (float)(h % 24);
+        float temp = level + 6.0f * sinf((hour - 9.0f) * (float)M_PI / 12.0f) + 0.6f * noise(rng);
+        float rush = expf(-powf((hour - 8.0f) / 1.5f, 2)) + expf(-powf((hour - 18.5f) / 2.0f, 2));
+        int aqi = (int)lroundf(std::max(5.0f, 28.0f + 24.0f * rush + 4.0f * noise(rng)));
+        trace.push_back({start + h * 3600, temp, aqi});
+    }
+    return trace;
+}
+
+// Valeur « current » à l'instant t, interpolée entre deux points de la trace.
+WeatherPoint at(const std::vector<WeatherPoint>& trace, uint32_t t) {
+    if (t <= trace.front().ts) return trace.front();
+    for (size_t i = 1; i < trace.size(); i++) {
+        if (t >= trace[i].ts) continue;
+        const WeatherPoint& a = trace[i - 1];
+        const WeatherPoint& b = trace[i];
+        float k = (float)(t - a.ts) / (float)(b.ts - a.ts);
+        return {t, a.temp + k * (b.temp - a.temp), (int)lroundf(a.aqi + k * (b.aqi - a.aqi))};
+    }
+    return trace.back();
+}
+
+struct Day {
+    uint64_t weatherRequests = 0;
+    uint64_t requests = 0;
+    uint64_t servoWrites = 0;
+    uint32_t toggles = 0;
+    uint32_t flaps = 0;
+    uint32_t minDwellS = 0;  // 0 : pas deux bascules dans la journée
+    uint64_t openMs = 0;
+    float tmax = -100.0f;
+    int aqiMax = 0;
+};
+
+// index 0 : ligne de total (ouvert% moyen)
+void printDay(bool csv, uint32_t index, uint32_t dayStart, const Day& d) {
+    char date[16] = "total";
+    time_t t = dayStart;
+    if (index) strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&t));
+    double openPct = 100.0 * d.openMs / (DAY_S * 1000.0);
+    if (csv) {
+        printf("%u,%s,%llu,%llu,%llu,%u,%u,%u,%.1f,%.1f,%d\n", index, date, (unsigned long long)d.requests,
+               (unsigned long long)d.weatherRequests, (unsigned long long)d.servoWrites, d.toggles, d.flaps,
+               d.minDwellS / 60, openPct, d.tmax, d.aqiMax);
+        return;
+    }
+    char dwell[16] = "-";
+    if (d.minDwellS) snprintf(dwell, sizeof(dwell), "%u", d.minDwellS / 60);
+    char day[12] = "";
+    if (index) snprintf(day, sizeof(day), "%u", index);
+    printf("%4s  %-10s  %8llu  %7llu  %6llu  %7u  %6u  %9s  %7.1f  %5.1f  %4d\n", day, date,
+           (unsigned long long)d.requests, (unsigned long long)d.weatherRequests, (unsigned long long)d.servoWrites,
+           d.toggles, d.flaps, dwell, openPct, d.tmax, d.aqiMax);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    uint32_t days = 7;
+    uint32_t seed = 1;
+    bool csv = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--days") && i + 1 < argc) days = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--csv")) csv = true;
+        else if (argv[i][0] != '-') tracePath = argv[i];
+        else {
+            fprintf(stderr, "usage: %s [trace.csv] [--days N] [--seed S] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<WeatherPoint> trace;
+    if (tracePath) {
+        if (!loadCsv(tracePath, trace)) {
+            fprintf(stderr, "sim: trace illisible ou trop courte : %s\n", tracePath);
+            return 1;
+        }
+        days = std::min(days, (trace.back().ts - trace.front().ts) / DAY_S);
+    } else {
+        trace = synthetic(days, seed);
+    }
+    uint32_t start = trace.front().ts - trace.front().ts % DAY_S;
+
+    hal::begin();
+    hal::setThreads(false);
+    hal::setQuiet(true);
+    static hal::SimClock clock((uint64_t)start * 1000000);
+    hal::setClock(&clock);
+
+    // Open-Meteo rejoue la trace à l'heure simulée, au pas de 15 min
+    uint64_t weatherRequests = 0;
+    hal::serve("api.open-meteo.com", 443, [&](const hal::HttpRequest& req, hal::HttpResponse& res) {
+        weatherRequests++;
+        if (req.path.rfind("/v1/forecast", 0) != 0) { res.status = 404; res.body = "{}"; return; }
+        // Valeur du dernier quart d'heure échu : le service ne publie qu'à ce pas
+        uint32_t now = (uint32_t)time(nullptr);
+        time_t t = now - now % 900;
+        WeatherPoint p = at(trace, (uint32_t)t);
+        char iso[24];
+        strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M", gmtime(&t));
+        char body[256];
+        snprintf(body, sizeof(body),
+                 "{\"current\":{\"time\":\"%s\",\"interval\":900,\"temperature_2m\":%.1f,\"european_aqi\":%d}}", iso,
+                 p.temp, p.aqi);
+        res.body = body;
+        res.chunked = true;
+    });
+
+    if (csv) printf("day,date,requests,weather,servo_writes,toggles,flaps,min_dwell_min,open_pct,tmax,aqi_max\n");
+    else printf(" day  date        requêtes  météo  servo  bascules  batt.  dwell min  ouvert%%  tmax   aqi\n");
+
+    auto wallStart = std::chrono::steady_clock::now();
+    const hal::Stats& stats = hal::stats();
+    Day day, total;
+    uint32_t dayIndex = 0;
+    uint32_t dayStart = start;
+    uint64_t requestsMark = stats.requests, weatherMark = 0, servoMark = stats.servoWrites;
+    int angle = stats.servoAngle;
+    int lastDir = 0;
+    uint32_t lastToggle = 0;
+    uint64_t lastMs = millis();
+    bool booted = false;
+
+    while (dayIndex < days) {
+        try {
+            if (!booted) {
+                setup();
+                booted = true;
+            }
+            loop();
+        } catch (const hal::Restart&) {
+            booted = false;
+        }
+
+        uint32_t now = (uint32_t)time(nullptr);
+        uint64_t ms = millis();
+        if (angle > 0) day.openMs += ms - lastMs;
+        lastMs = ms;
+        WeatherPoint w = at(trace, now);
+        day.tmax = std::max(day.tmax, w.temp);
+        day.aqiMax = std::max(day.aqiMax, w.aqi);
+
+        // Le servo avance par pas (profil de mouvement) : une bascule est un
+        // changement de sens de la course
+        if (stats.servoAngle != angle) {
+            int dir = stats.servoAngle > angle ? 1 : -1;
+            if (angle >= 0 && dir != lastDir) {
+                // Premier mouvement du boot exclu : ce n'est pas une décision
+                if (lastDir) {
+                    day.toggles++;
+                    if (lastToggle) {
+                        uint32_t dwell = now - lastToggle;
+                        if (dwell < FLAP_S) day.flaps++;
+                        if (!day.minDwellS || dwell < day.minDwellS) day.minDwellS = dwell;
+                    }
+                }
+                lastToggle = now;
+                lastDir = dir;
+            }
+            angle = stats.servoAngle;
+        }
+
+        if (now >= dayStart + DAY_S) {
+            day.requests = stats.requests - requestsMark;
+            day.weatherRequests = weatherRequests - weatherMark;
+            day.servoWrites = stats.servoWrites - servoMark;
+            printDay(csv, dayIndex + 1, dayStart, day);
+            total.requests += day.requests;
+            total.weatherRequests += day.weatherRequests;
+            total.servoWrites += day.servoWrites;
+            total.toggles += day.toggles;
+            total.flaps += day.flaps;
+            if (day.minDwellS && (!total.minDwellS || day.minDwellS < total.minDwellS)) total.minDwellS = day.minDwellS;
+            total.openMs += day.openMs;
+            total.tmax = std::max(total.tmax, day.tmax);
+            total.aqiMax = std::max(total.aqiMax, day.aqiMax);
+
+            requestsMark = stats.requests;
+            weatherMark = weatherRequests;
+            servoMark = stats.servoWrites;
+            day = Day();
+            dayIndex++;
+            dayStart += DAY_S;
+        }
+    }
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (!csv && days > 0) {
+        total.openMs /= days;
+        printf("------------------------------------------------------------------------------------------\n");
+        printDay(false, 0, start, total);
+        printf("moyenne/jour : %.0f requêtes, %.1f bascules (%.0f écritures servo), %.1f battements\n",
+               (double)total.requests / days, (double)total.toggles / days, (double)total.servoWrites / days,
+               (double)total.flaps / days);
+    }
+    fprintf(stderr, "[sim] %u jours simulés en %.2f s (x%.0f)\n", days, wall, wall > 0 ? days * DAY_S / wall : 0.0);
+    return 0;
+}